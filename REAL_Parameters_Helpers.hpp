@@ -14,8 +14,6 @@
 
 typedef std::chrono::high_resolution_clock hr_clock;
 
-// disease statuses capable of spreading infection
-const std::set<char> Infectious_Statuses = {'P', 'I', 'A'};
 // potential infection locales in the model
 const std::set<std::string> Infection_Places({"initial", "background", "house", "classroom", "commons"});
 
@@ -34,6 +32,47 @@ const float A_to_R_rate = 0.25;
 const float Probability_of_Adult_Developing_Symptoms = 0.6;
 const float Probability_of_Child_Developing_Symptoms = 0.4;
 
+/*
+	The disease model, as a table with one row per SEPAIR status:
+		infected - they're carrying the disease (the run goes on while anyone is)
+		infectious - they can pass it on
+		symptomatic - they show symptoms, so they start isolating (and their classroom may be shut) on getting there
+		off_sick - if they're isolating with this status, it's down to their own illness (and not, say, a classmate's)
+		rate - the chance per day of moving on from it (0 for the statuses they stay in)
+		next - where they move on to: the first with the chance in chance_of_first_next (for a child, then for an adult), the
+			second otherwise. if the two are the same, there's nothing to draw for
+	The Town and the simulation take everything they need to know about the statuses from here (compiled into arrays, see
+		Disease in REAL_Town.hpp), so other progression rates or branches can be tried by changing this table alone. The
+		agents are moved along in the order of the rows, one status after the other.
+*/
+struct Disease_Status_Row
+{
+	char status;
+	bool infected;
+	bool infectious;
+	bool symptomatic;
+	bool off_sick;
+	float rate;
+	char next[2];
+	float chance_of_first_next[2]; // index - 0 for a child, 1 for an adult
+};
+const Disease_Status_Row Disease_Model[] = {
+	//	status	infected	infectious	symptomatic	off_sick	rate			next		chance of first next (child, adult)
+	{	'S',	false,		false,		false,		false,		0,				{'S', 'S'},	{1, 1}	},
+	{	'E',	true,		false,		false,		false,		E_to_P_rate,	{'P', 'P'},	{1, 1}	},
+	{	'P',	true,		true,		false,		false,		P_to_Inf_rate,	{'I', 'A'},	{Probability_of_Child_Developing_Symptoms, Probability_of_Adult_Developing_Symptoms}	},
+	{	'I',	true,		true,		true,		true,		I_to_R_rate,	{'R', 'R'},	{1, 1}	},
+	{	'A',	true,		true,		false,		false,		A_to_R_rate,	{'R', 'R'},	{1, 1}	},
+	{	'R',	false,		false,		false,		true,		0,				{'R', 'R'},	{1, 1}	}
+};
+
+// disease statuses capable of spreading infection
+const std::set<char> Infectious_Statuses = [](){
+	std::set<char> statuses;
+	for(const Disease_Status_Row& row : Disease_Model){ if(row.infectious){ statuses.insert(row.status); } }
+	return statuses;
+}();
+
 // fixed backgrounnd rate of infection
 const float Background_Infection_Rate_H = 1.16e-4;
 const float Background_Infection_Not_in_School = 2.*Background_Infection_Rate_H;
@@ -42,8 +81,62 @@ const float Background_Infection_in_School = Background_Infection_Rate_H;
 // cohort 0 goes to the school every week
 const int Teacher_Cohort = 0;
 
+/*
+	count the index case's secondary infections as only its exposures that counted (see Town::num_infected_by), leaving out the
+		classmates it exposed who'd already caught it from someone else that day. it's a different number from the one we
+		publish, and it can put an instance in No_Secondary_Spread instead of With_Secondary_Spread
+*/
+const bool Count_Effective_Secondary_Infections = false;
+
+/*
+	Performance switches. Each one gives the same model, with the same chances of everything happening, but goes through the random
+		numbers differently (in a different order, fewer of them, or from a stream of their own), so with one switched on, the
+		instance run from a given seed isn't the one we'd get with it off; only the spread of results over the ensemble is the same.
+		The results we publish are reproduced number for number from the seeds, so they're all off for those.
+*/
+
+// number the agents by classroom and household once the population is built, so classmates and flatmates sit together in memory
+const bool Renumber_Agents_By_Locality = false;
+
+/*
+	make the extra teacher households that substitutes are drawn from only when a substitute is needed, or when someone in them catches
+		it in the community, instead of all of them up front. until then they're counted in the population and catch it at the same
+		rate as everyone else out of school
+*/
+const bool Substitute_Households_On_Demand = false;
+
+/*
+	spread the infection in the classrooms and the common area with one random draw per susceptible (their chance of catching it
+		from anyone in the room, worked out from the number of infectious children and adults there), instead of one draw per
+		infectious-susceptible pair. the index case keeps its own draw against each susceptible, so the secondary infections it's
+		credited with are counted the same way
+*/
+const bool Aggregate_School_Transmission = false;
+
+/*
+	the same for the infection spreading at home: one draw per susceptible in the households with someone spreading it (infectious
+		and not isolating), against everyone spreading it there at once, instead of one draw per infectious agent and flatmate
+*/
+const bool Aggregate_Home_Transmission = false;
+
+/*
+	pick the agents infected in the community (and the ones recovered at the start, R_init) by drawing the gaps between them,
+		instead of drawing for every agent
+*/
+const bool Geometric_Skip_Sampling = false;
+
+/*
+	move the agents along the disease progression on a schedule: the number of days each one spends in E, P, I and A is drawn
+		when they get there, instead of rolling the dice for everyone in those statuses every day
+*/
+const bool Event_Driven_Progression = false;
+
 const int Ensemble_Size = 10000;
 const int Number_of_Classrooms = 5;
+// the biggest classes we study - each cohort fills its own seats (the Town keeps its classrooms in fixed-size storage sized from these)
+const int Max_Children_per_Classroom = 30;
+const int Max_Teachers_per_Classroom = 3;
+const int Max_Child_Cohorts = 2;
 
 const std::vector<std::string> Class_Assignments_set ({"siblings", "random"}); // , "random"
 const std::vector<bool> Reduced_Hours_set ({true, false});
@@ -123,9 +216,9 @@ auto Get_Parameter_Combinations = []() -> void
 	for(float RI : R_init_set){
 	for(std::string Class_Arrange : std::set<std::string>({"siblings", "random"})){
 	for(bool Reduced : std::set<bool>({true, false})){
-	for(int num_child=2; num_child<=30; ++num_child){
-	for(int num_teacher=1; num_teacher<=3; ++num_teacher){
-	for(int num_cohorts=1; num_cohorts<=2; ++num_cohorts)
+	for(int num_child=2; num_child<=Max_Children_per_Classroom; ++num_child){
+	for(int num_teacher=1; num_teacher<=Max_Teachers_per_Classroom; ++num_teacher){
+	for(int num_cohorts=1; num_cohorts<=Max_Child_Cohorts; ++num_cohorts)
 	{
 		// get the name of the output file
 		const std::string file_stem = get_filename(A0, AC, BH, LAM, RI, Class_Arrange, num_child, num_teacher, num_cohorts, Reduced);
@@ -3,14 +3,137 @@
 
 #include <iostream>
 #include <limits>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "REAL_Town_Containers.hpp"
 
+/*
+	Places in the model where an agent can be infected. This used to be a string held by every agent; the enum is a single
+		byte and doesn't need a heap allocation every time an agent is copied.
+*/
+enum Infection_Locale : char
+{
+	Locale_None,		// not infected (or we don't care where, like the agents that start off exposed)
+	Locale_Initial,		// index case and the initially recovered agents
+	Locale_Background,	// community transmission
+	Locale_Home,		// household transmission
+	Locale_Class,		// classroom transmission
+	Locale_Commons		// transmission in the school common areas
+};
+const int Num_Infection_Locales = 6;
+
+// the names used for the locales in the string interface of the Town and in the printouts
+const char* const Infection_Locale_Names[Num_Infection_Locales] = {"", "initial", "background", "home", "class", "commons"};
+
+// converts the name of a locale to the enum. unknown names come back as Locale_None
+const Infection_Locale infection_locale_from_name(const std::string& place)
+{
+	for(int locale = 0; locale < Num_Infection_Locales; ++locale)
+	{
+		if(place == Infection_Locale_Names[locale]){ return static_cast<Infection_Locale>(locale); }
+	}
+	return Locale_None;
+}
+
+/*
+	Structure-of-arrays storage for the characteristics of all the agents in a Town.
+
+	Each characteristic is kept in its own contiguous array, indexed by the agent ID. The daily loops usually only look
+		at one or two characteristics of each agent (status and age, say), so this way they only pull those into the cache
+		instead of whole Person objects. Only the Town writes to it; Person objects handed out by the Town read from it.
+*/
+class Agent_Store
+{
+	friend class Person;
+	friend class Town;
+
+	private:
+
+		Town_Vector<char> _age; // categorical age - either child 'C' or adult 'A'
+		Town_Vector<char> _disease_status; // stage of the SEPAIR infection progression
+		Town_Vector<signed char> _cohort; // cohort the agent attends with (-1 if not attending the school)
+		Town_Vector<Infection_Locale> _infection_locale; // where they were infected
+		Town_Vector<short> _days_since_first_symptoms; // used for enforcing isolation
+		Town_Vector<int> _classroom; // classroom the agent is assigned to (-1 if not attending the school)
+		Town_Vector<int> _household; // household the agent lives in
+		Town_Vector<int> _time_step_infected_at; // tracks the passage of the infection
+		Town_Vector<int> _infected_by; // the agent who exposed them (-1 if nobody did: infected in the community, or not at all)
+		Town_Vector<int> _num_infected; // the number of agents they've exposed themselves
+
+		template<typename T> static void permute(Town_Vector<T>& characteristic, const std::vector<int>& new_number_of)
+		{
+			Town_Vector<T> moved(characteristic.size(), T(), characteristic.get_allocator());
+			for(int agent = 0; agent < (int)characteristic.size(); ++agent){ moved[new_number_of[agent]] = characteristic[agent]; }
+			characteristic.swap(moved);
+		}
+
+	public:
+
+		Agent_Store() {}
+		explicit Agent_Store(Town_Arena* arena)
+			: _age(arena), _disease_status(arena), _cohort(arena), _infection_locale(arena), _days_since_first_symptoms(arena),
+			  _classroom(arena), _household(arena), _time_step_infected_at(arena), _infected_by(arena), _num_infected(arena) {}
+
+		const int size() const { return _age.size(); }
+
+		void reserve(const int num_agents)
+		{
+			_age.reserve(num_agents);
+			_disease_status.reserve(num_agents);
+			_cohort.reserve(num_agents);
+			_infection_locale.reserve(num_agents);
+			_days_since_first_symptoms.reserve(num_agents);
+			_classroom.reserve(num_agents);
+			_household.reserve(num_agents);
+			_time_step_infected_at.reserve(num_agents);
+			_infected_by.reserve(num_agents);
+			_num_infected.reserve(num_agents);
+		}
+
+		// move every agent to their new number (new_number_of[old number] = new number)
+		void renumber(const std::vector<int>& new_number_of)
+		{
+			permute(_age, new_number_of);
+			permute(_disease_status, new_number_of);
+			permute(_cohort, new_number_of);
+			permute(_infection_locale, new_number_of);
+			permute(_days_since_first_symptoms, new_number_of);
+			permute(_classroom, new_number_of);
+			permute(_household, new_number_of);
+			permute(_time_step_infected_at, new_number_of);
+			permute(_infected_by, new_number_of);
+			for(int& source : _infected_by){ if(source != -1){ source = new_number_of[source]; } }
+			permute(_num_infected, new_number_of);
+		}
+
+		void clear()
+		{
+			_age.clear();
+			_disease_status.clear();
+			_cohort.clear();
+			_infection_locale.clear();
+			_days_since_first_symptoms.clear();
+			_classroom.clear();
+			_household.clear();
+			_time_step_infected_at.clear();
+			_infected_by.clear();
+			_num_infected.clear();
+		}
+};
+
+/*
+	A Person is either a standalone agent (built by the user and handed to Town::add_agent) or a view onto one of the agents
+		in a Town's Agent_Store (what Town::Agent gives back). A view is just a pointer and a number, so it's cheap to hand
+		out in the hot loops, and always shows the current state of the agent in the Town.
+*/
 class Person
 {
 	friend class Town;
 
 	private:
 
-		// AGENT CHARACTERISTICS
+		// AGENT CHARACTERISTICS - only used by standalone agents; views read them from the store
 
 		char _age; // categorical age of the agent - either child 'C' or adult 'A'
 		int _household; // number of the household containing the node
@@ -18,29 +141,64 @@ class Person
 		char _disease_status; // stage of the SEPAIR infection progression
 		int _identity; // individual number of the node - assigned when added to the network
 		int _days_since_first_symptoms; // number of days since first COVID-19-esque symptoms, used for enforcing isolation upon asymptomatic infection
-		std::string _infection_locale; // place where the agent got infected; background, home, class, common area
+		Infection_Locale _infection_locale; // place where the agent got infected; background, home, class, common area
 		int _cohort; // cohort that the student is in (single cohort can be modelled by placing all children in the same cohort)
 		int _time_step_infected_at; // tracks the passage of the infection, whether or not the agent is asymptomatic
 
+		// the store this agent lives in, if it's a view onto an agent in a Town
+		const Agent_Store* _store;
+
+		// view onto agent number "index" of the store - only the Town hands these out
+		Person(const Agent_Store* store, const int index)
+		{
+			_age = '\0';
+			_household = 0;
+			_classroom = 0;
+			_disease_status = '\0';
+			_identity = index;
+			_days_since_first_symptoms = -1;
+			_infection_locale = Locale_None;
+			_cohort = -1;
+			_time_step_infected_at = 0;
+			_store = store;
+		}
+
+		// copy the characteristics out of the store so that the setters don't write into the Town behind its back
+		void detach()
+		{
+			if(_store == nullptr) return;
+			_age = age();
+			_household = household();
+			_classroom = classroom();
+			_disease_status = status();
+			_days_since_first_symptoms = days_since_first_symptoms();
+			_infection_locale = infection_locale();
+			_cohort = cohort();
+			_time_step_infected_at = _store->_time_step_infected_at[_identity];
+			_store = nullptr;
+		}
+
 	public:
 
 		// GETTERS
 
 		const int ID() const { return _identity; }
-		const char age() const { return _age; }
-		const int household() const { return _household; }
-		const char status() const { return _disease_status; }
-		const bool is_susceptible() { return (_disease_status == 'S'); }
-		const int classroom() const { return _classroom; }
-		const int days_since_first_symptoms() const { return _days_since_first_symptoms; }
-		const int cohort() const { return _cohort; }
-		const std::string infection_locale() const { return _infection_locale;}
+		const char age() const { return _store ? _store->_age[_identity] : _age; }
+		const int household() const { return _store ? _store->_household[_identity] : _household; }
+		const char status() const { return _store ? _store->_disease_status[_identity] : _disease_status; }
+		const bool is_susceptible() { return (status() == 'S'); }
+		const int classroom() const { return _store ? _store->_classroom[_identity] : _classroom; }
+		const int days_since_first_symptoms() const { return _store ? _store->_days_since_first_symptoms[_identity] : _days_since_first_symptoms; }
+		const int cohort() const { return _store ? _store->_cohort[_identity] : _cohort; }
+		const Infection_Locale infection_locale() const { return _store ? _store->_infection_locale[_identity] : _infection_locale; }
+		const char* infection_locale_name() const { return Infection_Locale_Names[infection_locale()]; }
 		const int weekend_offset() const
 		{
 			// if the node gets sick over the weekend, notify the school at the beginning of the next week
-			if(_disease_status != 'I') return 0;
+			if(status() != 'I') return 0;
 			// see where we are in the week, throw away Mon-Fri, and count the remainders
-			return std::max(_time_step_infected_at%7-4, 0);
+			const int time_step_infected_at = _store ? _store->_time_step_infected_at[_identity] : _time_step_infected_at;
+			return std::max(time_step_infected_at%7-4, 0);
 
 		}
 
@@ -55,6 +213,8 @@ class Person
 			_infection_locale = other._infection_locale;
 			_cohort = other._cohort;
 			_time_step_infected_at = other._time_step_infected_at;
+			_store = other._store;
+			if(_store != nullptr){ _identity = other._identity; } // a view is nothing without the number of the agent
 			return *this;
 		}
 
@@ -66,12 +226,13 @@ class Person
 			_classroom = std::numeric_limits<int>::quiet_NaN();
 			_identity = std::numeric_limits<int>::quiet_NaN();
 			_days_since_first_symptoms = -1;
-			_infection_locale = "";
+			_infection_locale = Locale_None;
 			_time_step_infected_at = 0;
 			_cohort = -1;
+			_store = nullptr;
 		}
 
-		Person(const char age, const int household, const char illness, const int classr, const int cohort_num=-1, const std::string place_of_infection="")
+		Person(const char age, const int household, const char illness, const int classr, const int cohort_num=-1, const Infection_Locale place_of_infection=Locale_None)
 		{
 			_age = age;
 			_household = household;
@@ -82,6 +243,7 @@ class Person
 			_infection_locale = place_of_infection;
 			_cohort = cohort_num;
 			_time_step_infected_at = 0;
+			_store = nullptr;
 		}
 
 		Person(const Person& other)
@@ -96,6 +258,7 @@ class Person
 			_infection_locale = other._infection_locale;
 			_cohort = other._cohort;
 			_time_step_infected_at = other._time_step_infected_at;
+			_store = other._store;
 		}
 
 		Person(Person&& other)
@@ -109,6 +272,7 @@ class Person
 			_infection_locale = other._infection_locale;
 			_cohort = other._cohort;
 			_time_step_infected_at = other._time_step_infected_at;
+			_store = other._store;
 
 			other._age = '\0';
 			other._household = std::numeric_limits<int>::quiet_NaN();
@@ -116,9 +280,10 @@ class Person
 			other._classroom = std::numeric_limits<int>::quiet_NaN();
 			other._identity = std::numeric_limits<int>::quiet_NaN();
 			other._days_since_first_symptoms = -1;
-			other._infection_locale = "";
+			other._infection_locale = Locale_None;
 			other._cohort = -1;
 			other._time_step_infected_at = 0;
+			other._store = nullptr;
 		}
 
 	// protected:
@@ -130,26 +295,30 @@ class Person
 			To avoid a characteristic being updated in one place but not the other, these setter functions are hidden from
 			the user, and everything is changed consistently by the Town class interface. Getters are not hidden since
 			they have no side effects
+
+			The Town doesn't use these anymore (it writes straight to its Agent_Store). Setting a characteristic on a view
+				turns it into a standalone copy of the agent first, so the Town never sees the change.
 		*/
 
-		void set_identity(const int n) { _identity = n; }
-		void set_age(const int n) { _age = n; }
-		void set_household(const int n) { _household = n; }
+		void set_identity(const int n) { detach(); _identity = n; }
+		void set_age(const int n) { detach(); _age = n; }
+		void set_household(const int n) { detach(); _household = n; }
 		void set_status(const char illness, const char infec_time=0)
 		{
+			detach();
 			_time_step_infected_at = infec_time;
 			_disease_status = illness;
 		}
-		void set_classroom(const int classr) { _classroom = classr; }
-		void set_days_since_first_symptoms(const int num_days, const int weekend_infection=0){ _days_since_first_symptoms = num_days; }
-		void add_day_since_first_symptoms(void) { _days_since_first_symptoms += 1; }
-		void set_infection_locale(const std::string place) { _infection_locale = place; }
-		void set_cohort(const int cohort_number) { _cohort = cohort_number; }
+		void set_classroom(const int classr) { detach(); _classroom = classr; }
+		void set_days_since_first_symptoms(const int num_days, const int weekend_infection=0){ detach(); _days_since_first_symptoms = num_days; }
+		void add_day_since_first_symptoms(void) { detach(); _days_since_first_symptoms += 1; }
+		void set_infection_locale(const Infection_Locale place) { detach(); _infection_locale = place; }
+		void set_cohort(const int cohort_number) { detach(); _cohort = cohort_number; }
 };
 
 std::ostream& operator << (std::ostream& out, Person const& agent)
 {
-	out << "Agent # " << agent.ID() << ". Age: " << agent.age() << ". Assigned to household #" << agent.household() << ". In class #" << agent.classroom() << ". Disease status " << agent.status() << ". Time spent in isolation " << agent.days_since_first_symptoms() <<  ". Infected at location: " << agent.infection_locale() << ".";
+	out << "Agent # " << agent.ID() << ". Age: " << agent.age() << ". Assigned to household #" << agent.household() << ". In class #" << agent.classroom() << ". Disease status " << agent.status() << ". Time spent in isolation " << agent.days_since_first_symptoms() <<  ". Infected at location: " << agent.infection_locale_name() << ".";
 	return out;
 }
 
@@ -1,6 +1,8 @@
 #include "REAL_Town.hpp"
+#include "REAL_Transmission_Kernel.hpp"
 #include "Timing.hpp"
 #include <execution>
+#include <cmath>
 
 int main(int argc, char *argv[])
 {
@@ -14,7 +16,7 @@ TIC(0);
 	// // for a small initial test run
 	// Parameter_Tuples = {Parameter_Tuples[0]};
 
-	std::for_each(std::execution::par_unseq, Parameter_Tuples.begin(), Parameter_Tuples.end(), [&](auto&& parameter_tuple) // for the actual run
+	std::for_each(std::execution::par, Parameter_Tuples.begin(), Parameter_Tuples.end(), [&](auto&& parameter_tuple) // for the actual run
 	// std::for_each(std::execution::seq, Parameter_Tuples.begin(), Parameter_Tuples.end(), [&](auto&& parameter_tuple) // for testing
 	{
 		// take a parameter tuple and get the individual parameter values
@@ -33,6 +35,41 @@ TIC(0);
 		const float B_C = Alpha_C*B_H;
 		const float B_0 = Alpha_0*B_C;
 
+		/*
+			The chance of infection for one infectious-susceptible pair in each place the agents pass it on to each other (and at
+				home, on weekdays and on weekends), worked out once for the tuple from the contact matrices and the transmission
+				rates, so the transmission loops below only have to look them up.
+			In school, the chances are halved in the reduced hours scenario. At home, B_H is boosted by 50% on weekends (presumably
+				increased interaction), and by 100% in the reduced hours scenario (the increased amount of time spent at home
+				with the flatmates).
+			Index: [place][age of the infectious agent][age of the susceptible one], 0 for a child and 1 for an adult
+			pair_chance - the chance, the way the aggregate transmission has it (single precision, no more than 1)
+			pair_threshold - what the pair-by-pair transmission compares each pair's draw against (see draw_threshold), from the
+				chance the way it's always been worked out there (double precision)
+		*/
+		enum Transmission_Place { Place_Classroom, Place_Commons, Place_Home_Weekday, Place_Home_Weekend, Num_Transmission_Places };
+		float pair_chance[Num_Transmission_Places][2][2];
+		float pair_threshold[Num_Transmission_Places][2][2];
+		for(int inf_age = 0; inf_age < 2; ++inf_age)
+		{
+			for(int sus_age = 0; sus_age < 2; ++sus_age)
+			{
+				const float School_Rate = Town::School_Contact_Matrix[inf_age][sus_age];
+				pair_chance[Place_Classroom][inf_age][sus_age] = std::min(1.0f, (1 - 0.5f*(!!Reduced_Hours))*B_C*School_Rate);
+				pair_chance[Place_Commons][inf_age][sus_age] = std::min(1.0f, (1 - 0.5f*(!!Reduced_Hours))*B_0*School_Rate);
+				pair_threshold[Place_Classroom][inf_age][sus_age] = draw_threshold((1 - 0.5*(!!Reduced_Hours))*B_C*School_Rate);
+				pair_threshold[Place_Commons][inf_age][sus_age] = draw_threshold((1 - 0.5*(!!Reduced_Hours))*B_0*School_Rate);
+
+				const float Home_Rate = Town::Home_Contact_Matrix[inf_age][sus_age];
+				for(int weekend = 0; weekend < 2; ++weekend)
+				{
+					pair_chance[Place_Home_Weekday + weekend][inf_age][sus_age] = std::min(1.0f, (1 + 0.5f*weekend + (!!Reduced_Hours))*B_H*Home_Rate);
+					// a flatmate catches it if their draw is at or below the chance
+					pair_threshold[Place_Home_Weekday + weekend][inf_age][sus_age] = draw_threshold_at_or_below((1 + 0.5*weekend + (!!Reduced_Hours))*B_H*Home_Rate);
+				}
+			}
+		}
+
 		// get the file stem, and if the run has already been completed, exit
 		const std::string File_Stem = get_filename(Alpha_0, Alpha_C, B_H, Background_Infection_Rate, R_init, Classroom_Arrangement, Num_Children_per_Classroom, Num_Teachers_per_Classroom, Num_Child_Cohorts, Reduced_Hours);
 
@@ -60,6 +97,14 @@ TIC(0);
 		std::stringstream no_secondary_infections_output {};
 		std::stringstream yes_secondary_infections_output {};
 
+		/*
+			One Town per worker thread, used for every instance (and every parameter tuple) that thread runs. It's reset at the
+				start of each instance, which empties it but keeps all the storage it's grown, so it's only allocated the once.
+			That's why the tuples are run with std::execution::par and not par_unseq: par_unseq lets the runs of two tuples be
+				interleaved on the same thread, and they'd be sharing the one Town.
+		*/
+		thread_local Town NorthShore;
+
 		for(int Instance=0; Instance<Ensemble_Size; ++Instance)
 		{
 			/*
@@ -84,7 +129,8 @@ TIC(0);
 			std::mt19937 generator(Random_Seed);
 			std::uniform_real_distribution<float> randfloat(0,1);
 
-			Town NorthShore;
+			// start from an empty town
+			NorthShore.reset();
 
 			/*
 				we'll be using this counter for both the do-while loops
@@ -292,7 +338,11 @@ TIC(0);
 				}
 			}
 
-			assert(set_of_values(set_of_values( NorthShore.classrooms() )).size() == Num_Children_per_Classroom*Number_of_Classrooms);
+			assert(std::accumulate(
+				NorthShore.classrooms().begin(),
+				NorthShore.classrooms().end(), 0,
+				[](int accumulator, const std::pair<int, Agent_Range> classr){ return accumulator+classr.second.size(); }
+			) == Num_Children_per_Classroom*Number_of_Classrooms);
 
 			/*
 				Creation of the teacher households, using the same household counter from before
@@ -303,40 +353,18 @@ TIC(0);
 					household at this centre, with no cohabiting children and teachers attending the same centre
 			*/
 			const int Substitute_Teacher_Factor = 3;
+			const int Num_Teacher_Households = Substitute_Teacher_Factor*Num_Teachers_per_Classroom*Number_of_Classrooms;
+			// with substitute households made on demand, only make the houses the teachers themselves come from for now
+			const int Num_Teacher_Households_Up_Front = Substitute_Households_On_Demand ? Num_Teachers_per_Classroom*Number_of_Classrooms : Num_Teacher_Households;
 			std::vector<int> teacher_households;
 			do
 			{
-				// if it's a house with just adults
-				if(randfloat(generator) < Percentage_Teachers_With_No_Children)
-				{
-					// get the house size from the distribution
-					const int Number_of_Adults = NorthShore.just_adults_household_size_distribution(randfloat(generator));
-					// throw them all in the same flat
-					for(int num_adults=0; num_adults < Number_of_Adults; ++num_adults)
-					{
-						NorthShore.add_agent(Person('A', household_number, 'S', -1));
-					}
-				}
-				else  // there are children in the house too
-				{
-					// get the house size from the distribution
-					const std::pair<int, int> Children_First_Adults_Second = NorthShore.children_and_adults_household_size_distribution(randfloat(generator));
-					// throw the children in there
-					for(int num_children=0; num_children < Children_First_Adults_Second.first; ++num_children)
-					{
-						NorthShore.add_agent(Person('C', household_number, 'S', -1));
-					}
-					// aaaand the adults...
-					for(int num_adults=0; num_adults < Children_First_Adults_Second.second; ++num_adults)
-					{
-						NorthShore.add_agent(Person('A', household_number, 'S', -1));
-					}
-				}
+				NorthShore.add_teacher_household(household_number, generator);
 				// move on to the next house
 				teacher_households.push_back(household_number);
 				++ household_number;
 			}
-			while(teacher_households.size() < Substitute_Teacher_Factor*Num_Teachers_per_Classroom*Number_of_Classrooms);
+			while(teacher_households.size() < Num_Teacher_Households_Up_Front);
 
 			// classrooms are filled - now to pick teachers - no two from the same household
 			int running_classroom_number = 0;
@@ -345,11 +373,14 @@ TIC(0);
 				// increment the classroom number when we fill one room
 				if((index%Num_Teachers_per_Classroom==0) & (index!=0)) ++running_classroom_number;
 				// get the adults in the teacher household
-				std::vector<int> adults = NorthShore.adults_in_household( teacher_households[index] );
+				const Town_Vector<int> adults = NorthShore.adults_in_household( teacher_households[index] );
 				// assign the first one to the classroom at hand
 				NorthShore.set_classroom(adults[0], running_classroom_number, Teacher_Cohort);
 			}
 
+			// everyone's in place, so lay the agents out by classroom and household before the transmission loops start going through them
+			if(Renumber_Agents_By_Locality){ NorthShore.renumber_agents_by_locality(); }
+
 			/*
 				we kick off the infection by changing one of the susceptible school attendees to the presymptomatic disease status,
 					and then we just let their health evolve as normal. most of these index cases will not produce secondary infections.
@@ -357,21 +388,64 @@ TIC(0);
 					population wastes less computational time waiting for the disease to "spread there eventually".
 			*/
 
+			/*
+				with Event_Driven_Progression, everyone's time in each disease status is worked out as soon as they get there: each
+					day in E, P, I or A they'd move on with the given rate, so the number of days they stay is geometrically
+					distributed. the Town keeps them on its schedule until the day they're due (see Town::schedule_transition)
+			*/
+			if(Event_Driven_Progression){ NorthShore.record_status_arrivals(true); }
+			auto schedule_the_arrivals = [&]()
+			{
+				for(const int agent : NorthShore.status_arrivals())
+				{
+					const float rate = Disease.rate[status_index(NorthShore.Agent(agent).status())];
+					if(rate == 0){ continue; } // nowhere to go from here
+					// the first day they're checked counts, so it's one day plus the number of days they don't move on before that
+					const int days_in_status = 1 + ((rate < 1) ? std::geometric_distribution<int>(rate)(generator) : 0);
+					NorthShore.schedule_transition(agent, NorthShore.days_elapsed() + days_in_status);
+				}
+				NorthShore.clear_status_arrivals();
+			};
+
+			/*
+				where an agent moving on from the given status (by number) goes next. where the disease model has them branch (P
+					to I or A, depending on whether they develop symptoms), children and adults have different chances
+			*/
+			auto next_status = [&](const int agent, const int state)
+			{
+				const std::array<char, 2>& next = Disease.next[state];
+				if(next[0] == next[1]){ return next[0]; }
+				const int age = (NorthShore.Agent(agent).age() == 'A');
+				return (randfloat(generator) < Disease.chance_of_first_next[state][age]) ? next[0] : next[1];
+			};
+
 			// get the susceptible school attendees, put them in an unsorted container, shuffle them, get the first person
-			std::set<int> S_agents( NorthShore.agents_in_school({'S'}) );
+			const Agent_Group S_agents = NorthShore.agents_in_school({'S'});
 			std::vector<int> School_Susceptibles(S_agents.begin(), S_agents.end());
 			std::random_shuffle(School_Susceptibles.begin(), School_Susceptibles.end());
 			// infect this index case
 			const int Index_Case = School_Susceptibles.front();
-			NorthShore.set_status(Index_Case, 'P', "initial");
+			NorthShore.set_status(Index_Case, 'P', Locale_Initial);
 
 			// setting the initial proportion of recovered agents
-			for(int person : NorthShore)
+			if(Geometric_Skip_Sampling)
+			{
+				for_each_sampled(NorthShore.agents('S'), R_init, generator, [&](const int person){ NorthShore.set_status(person, 'R', Locale_Initial); });
+			}
+			else
 			{
-				if(NorthShore.Agent(person).status() != 'S'){ continue; }
-				if(randfloat(generator) < R_init){ NorthShore.set_status(person, 'R', "initial"); }
+				for(int person : NorthShore)
+				{
+					if(NorthShore.Agent(person).status() != 'S'){ continue; }
+					if(randfloat(generator) < R_init){ NorthShore.set_status(person, 'R', Locale_Initial); }
+				}
 			}
 
+			if(Event_Driven_Progression){ schedule_the_arrivals(); }
+
+			// the rest of the substitute households are only made if they're needed
+			if(Substitute_Households_On_Demand){ NorthShore.keep_substitute_households_in_reserve(Num_Teacher_Households-Num_Teacher_Households_Up_Front, R_init, Random_Seed); }
+
 			/*
 			 	We'll calculate the R_e value of the infection by counting the number of secondary infections due to this first randomly
 				infected agent. It also gives us the time to the first infection, by getting the first time when this number moves above zero.
@@ -413,16 +487,16 @@ TIC(0);
 					<< Instance << ","
 					<< run_counter << ","
 					<< NorthShore.currently_the_weekend() << ","
-					<< NorthShore.closed_classrooms().size() << ","
+					<< NorthShore.num_closed_classrooms() << ","
 					<< NorthShore.child_closure_days() << ",";
 					// must be done as vectors so that the states stay in predictable order, rather than being sorted
 					for(char status : std::vector<int>({'S','E','P','A','I','R'})){ local_output_buffer << NorthShore.agents_proportion(status) << ","; }
 					for(char status : std::vector<int>({'S','E','P','A','I','R'})){ local_output_buffer << NorthShore.agents_in_school_proportion(status) << ","; }
 				local_output_buffer
-					<< NorthShore.locale_infections("background") << ","
-					<< NorthShore.locale_infections("home") << ","
-					<< NorthShore.locale_infections("class") << ","
-					<< NorthShore.locale_infections("commons") << ","
+					<< NorthShore.locale_infections(Locale_Background) << ","
+					<< NorthShore.locale_infections(Locale_Home) << ","
+					<< NorthShore.locale_infections(Locale_Class) << ","
+					<< NorthShore.locale_infections(Locale_Commons) << ","
 					<< number_of_secondary_infections
 				<< '\n';
 			};
@@ -430,104 +504,314 @@ TIC(0);
 			// record the initial state of the network
 			write_results();
 
-			// in that case, intentionally infect someone in the school see what happens
-			do
+			/*
+				ask for an exposure by someone in particular, crediting the index case with every one of its own that's asked for
+					(unless only the ones that counted are credited - see Count_Effective_Secondary_Infections)
+			*/
+			auto expose = [&](const int agent, const Infection_Locale locale, const int source)
 			{
-				// background infection (coffee shops, Walmart, Grindr hookups, you know the drill...)
-				for(int susceptible : NorthShore.agents('S'))
+				if((not Count_Effective_Secondary_Infections) and (source == Index_Case)){ ++ number_of_secondary_infections; }
+				NorthShore.expose(agent, locale, source);
+			};
+
+			/*
+				spreading the infection in a place all at once (Aggregate_School_Transmission, Aggregate_Home_Transmission): each
+					susceptible escapes every infectious agent there independently, so their chance of catching it is
+					1 - (1-p_C)^(# infectious children) * (1-p_A)^(# infectious adults), with p_C and p_A the per-pair chances for
+					their age. that's one draw per susceptible. if they do catch it, the source is picked from the infectious agents
+					in proportion to how likely each one was to pass it on
+
+				the index case keeps a draw of its own against every susceptible in the room, as it has pair by pair, and only the
+					rest of the infectious agents are lumped together. whoever it hits caught it from the index case, so it's credited
+					with every hit, and number_of_secondary_infections means the same as it does pair by pair. picking it as the
+					source instead only credits it with the ones nobody else hit, which undercounts it
+
+				work_out_the_chances fills in, for a susceptible child or adult (first index, 0 for the children), the chance of
+					catching it from one infectious child or adult (second index) in the given place (see pair_chance), and the
+					chance of catching it from any of them
+			*/
+			const char Ages[2] = {'C', 'A'};
+			float chance_from_one[2][2];
+			float chance_of_infection[2];
+			auto work_out_the_chances = [&](const Transmission_Place place, const int num_infectious_children, const int num_infectious_adults)
+			{
+				const int num_infectious[2] = {num_infectious_children, num_infectious_adults};
+				for(int sus_age = 0; sus_age < 2; ++sus_age)
 				{
-					// double the rate for individuals who do not go to the school
-					if(NorthShore.Agent(susceptible).classroom() == -1)
+					double chance_of_escape = 1;
+					for(int inf_age = 0; inf_age < 2; ++inf_age)
 					{
-						if(randfloat(generator) < Background_Infection_Not_in_School){ NorthShore.set_status(susceptible, 'E', "background"); }
+						chance_from_one[sus_age][inf_age] = pair_chance[place][inf_age][sus_age];
+						chance_of_escape *= std::pow(1. - chance_from_one[sus_age][inf_age], (double)num_infectious[inf_age]);
 					}
-					else
+					chance_of_infection[sus_age] = 1 - chance_of_escape;
+				}
+			};
+			// whether the source of a susceptible's infection was an adult - the children and adults are weighed by how many there are and how catching they are
+			auto caught_it_from_an_adult = [&](const int sus_age, const int num_infectious_children, const int num_infectious_adults)
+			{
+				const float from_the_children = num_infectious_children*chance_from_one[sus_age][0];
+				const float from_the_adults = num_infectious_adults*chance_from_one[sus_age][1];
+				return (from_the_children == 0) or ((from_the_adults != 0) and (randfloat(generator)*(from_the_children + from_the_adults) >= from_the_children));
+			};
+
+			// the infection spreading in a room (a classroom, or the common area). the agents are given as slots, and ID_of turns a slot into the agent's ID
+			std::array<std::vector<int>, 2> infectious_by_age; // index - 0 for the children, 1 for the adults
+			auto spread_in_the_room = [&](const Agent_Group& infectious, const Agent_Group& susceptible, const auto& ID_of, const Transmission_Place place, const Infection_Locale locale)
+			{
+				for(std::vector<int>& the_infectious : infectious_by_age){ the_infectious.clear(); }
+				int index_age = -1; // 0 for a child and 1 for an adult, if the index case is here spreading it
+				for(const int inf : infectious)
+				{
+					const int agent = ID_of(inf);
+					if(agent == Index_Case){ index_age = (NorthShore.Agent(agent).age() == 'A'); }
+					else { infectious_by_age[NorthShore.Agent(agent).age() == 'A'].push_back(agent); }
+				}
+				if(infectious_by_age[0].empty() and infectious_by_age[1].empty() and (index_age < 0)){ return; }
+
+				work_out_the_chances(place, infectious_by_age[0].size(), infectious_by_age[1].size());
+
+				for(const int sus_slot : susceptible)
+				{
+					const int sus = ID_of(sus_slot);
+					// they were exposed already today, at home or in their classroom
+					if(NorthShore.exposure_pending(sus)){ continue; }
+					const int sus_age = (NorthShore.Agent(sus).age() == 'A');
+					if((index_age >= 0) and (randfloat(generator) < pair_chance[place][index_age][sus_age]))
 					{
-						// just the plain old exposure rate
-						if(randfloat(generator) < Background_Infection_in_School){ NorthShore.set_status(susceptible, 'E', "background"); }
+						expose(sus, locale, Index_Case);
+						continue;
 					}
+					if(randfloat(generator) >= chance_of_infection[sus_age]){ continue; }
+
+					// they caught it from someone
+					const std::vector<int>& the_sources = infectious_by_age[caught_it_from_an_adult(sus_age, infectious_by_age[0].size(), infectious_by_age[1].size())];
+					const int source = the_sources[std::min<int>(randfloat(generator)*the_sources.size(), the_sources.size()-1)];
+					expose(sus, locale, source);
+				}
+			};
+
+			/*
+				the infection spreading in a room pair by pair: one draw for every infectious-susceptible pair, infectious agents in the
+					outer loop and susceptibles in the inner one, same as always. each infectious agent's row of draws is made in one
+					go, and then checked against the chances of infection all at once (see REAL_Transmission_Kernel.hpp)
+
+				the chances only depend on the ages, so each susceptible's threshold is worked out once for an infectious child and
+					once for an infectious adult, for the whole room. the agents are given as slots, and ID_of turns a slot into an ID
+
+				anyone exposed already today isn't tried. in a classroom that's decided once, when the room is started on, so
+					everyone left gets a draw from every infectious agent there; in the common area, whoever catches it from one
+					infectious agent isn't tried again by the ones after them either
+			*/
+			std::vector<int> susceptible_IDs;
+			std::array<std::vector<float>, 2> thresholds; // index - age of the infectious agent, 0 for a child and 1 for an adult
+			std::vector<float> draws;
+			std::vector<int> hits;
+			auto spread_pair_by_pair = [&](const Agent_Group& infectious, const Agent_Group& susceptible, const auto& ID_of, const Transmission_Place place, const Infection_Locale locale)
+			{
+				susceptible_IDs.clear();
+				for(const int sus_slot : susceptible)
+				{
+					if(not NorthShore.exposure_pending(ID_of(sus_slot))){ susceptible_IDs.push_back(ID_of(sus_slot)); }
 				}
+				int num_susceptible = susceptible_IDs.size();
+				if(num_susceptible == 0){ return; }
+
+				for(int inf_age = 0; inf_age < 2; ++inf_age)
+				{
+					thresholds[inf_age].resize(num_susceptible);
+					for(int sus = 0; sus < num_susceptible; ++sus)
+					{
+						thresholds[inf_age][sus] = pair_threshold[place][inf_age][NorthShore.Agent(susceptible_IDs[sus]).age() == 'A'];
+					}
+				}
+				draws.resize(num_susceptible);
+				hits.resize(num_susceptible);
+
+				for(const int inf_slot : infectious)
+				{
+					const int inf = ID_of(inf_slot);
+					for(float& draw : draws){ draw = randfloat(generator); }
+					const int num_hits = bernoulli_hits(draws.data(), thresholds[NorthShore.Agent(inf).age() == 'A'].data(), num_susceptible, hits.data());
+					for(int hit = 0; hit < num_hits; ++hit){ expose(susceptible_IDs[hits[hit]], locale, inf); }
+
+					// in the common area, squeeze the ones just exposed out of the room (the hits are in order)
+					if((locale == Locale_Commons) and (num_hits != 0))
+					{
+						int num_left = 0;
+						for(int sus = 0, hit = 0; sus < num_susceptible; ++sus)
+						{
+							if((hit < num_hits) and (hits[hit] == sus)){ ++hit; continue; }
+							susceptible_IDs[num_left] = susceptible_IDs[sus];
+							thresholds[0][num_left] = thresholds[0][sus];
+							thresholds[1][num_left] = thresholds[1][sus];
+							++num_left;
+						}
+						num_susceptible = num_left;
+						draws.resize(num_susceptible);
+					}
+				}
+			};
+
+			/*
+				the infection spreading between the agents, at home, in the classrooms and in the common area: compiled once for the
+					weekend and once for the weekdays, so which of the two it is doesn't have to be checked along the way
+			*/
+			auto spread_the_infection = [&](auto the_weekend)
+			{
+				constexpr bool Weekend = decltype(the_weekend)::value;
 
 				// spreading the infection to everyone living in the flat
-				for(int infectious : NorthShore.agents(Infectious_Statuses))
+				constexpr Transmission_Place home_today = Weekend ? Place_Home_Weekend : Place_Home_Weekday;
+				if(Aggregate_Home_Transmission)
 				{
 					/*
-						right now, we're assuming that children and teachers sent home after outbreaks in their classroom can and will
-							effectively self-isolate from other members of the household - a very conservative assumption
-						*/
-					if(NorthShore.is_in_isolation(infectious)){ continue; }
+						only the households with someone in them who can spread it (infectious, and not isolating - see below) are
+							looked at, and everyone susceptible in them gets one draw against all of them at once. the Town keeps
+							count of who's spreading it in every household (see Town::home_pressure)
+					*/
+					for(const int house : NorthShore.households_under_pressure())
+					{
+						const int num_infectious_children = NorthShore.home_pressure(house, 'C');
+						const int num_infectious_adults = NorthShore.home_pressure(house, 'A');
+						// boosted on weekends and in the reduced hours scenario, the same as below
+						work_out_the_chances(home_today, num_infectious_children, num_infectious_adults);
 
-					// for each infectious person in the simulation, get their flat
-					std::vector<int> the_house = NorthShore.household(NorthShore.Agent(infectious).household());
-					for(int flatmate : the_house)
+						const Agent_Range the_house = NorthShore.household(house);
+						for(int flatmate : the_house)
+						{
+							// must be susceptible to the infection (and not exposed already today)
+							if((NorthShore.Agent(flatmate).status() != 'S') or NorthShore.exposure_pending(flatmate)) { continue; }
+							const int mate_age = (NorthShore.Agent(flatmate).age() == 'A');
+							if(randfloat(generator) >= chance_of_infection[mate_age]){ continue; }
+
+							// they caught it from one of their flatmates - pick which one
+							const char Sick_Age = Ages[caught_it_from_an_adult(mate_age, num_infectious_children, num_infectious_adults)];
+							int which_one = randfloat(generator)*NorthShore.home_pressure(house, Sick_Age);
+							int source = -1;
+							for(int sick : the_house)
+							{
+								if((not NorthShore.is_spreading_at_home(sick)) or (NorthShore.Agent(sick).age() != Sick_Age)){ continue; }
+								source = sick;
+								if(which_one-- == 0){ break; }
+							}
+							expose(flatmate, Locale_Home, source);
+						}
+					}
+				}
+				else
+				{
+					for(int infectious : NorthShore.agents(Infectious_Statuses))
 					{
-						// try to infect all the susceptibles in the flat
-						if(flatmate == infectious) { continue; } // can't be the same person
-						if(NorthShore.Agent(flatmate).status() != 'S') { continue; } // must be susceptible to the infection
-						char sick_age = NorthShore.Agent(infectious).age();
-						char mate_age = NorthShore.Agent(flatmate).age();
-						// boost B^H by 50% on weekends because of presumably increased interaction
-						// boost B_H during reduced hours to represent the increased amount of time spent at home with the flatmates
-						// currently_the_weekend is true/false, or 0/1
-						// so is the Reduced class time variable
-						if(randfloat(generator) <= (1 + 0.5*(!!NorthShore.currently_the_weekend()) + (!!Reduced_Hours))*B_H*NorthShore.home_contact_rate(sick_age, mate_age))
+						/*
+							right now, we're assuming that children and teachers sent home after outbreaks in their classroom can and will
+								effectively self-isolate from other members of the household - a very conservative assumption
+							*/
+						if(NorthShore.is_in_isolation(infectious)){ continue; }
+
+						// for each infectious person in the simulation, get their flat
+						const Agent_Range the_house = NorthShore.household(NorthShore.Agent(infectious).household());
+						// B_H boosted on weekends and in the reduced hours scenario (see pair_threshold)
+						const float* const the_thresholds = pair_threshold[home_today][NorthShore.Agent(infectious).age() == 'A'];
+						for(int flatmate : the_house)
 						{
-							NorthShore.set_status(flatmate, 'E', "home");
-							// if the infection was produced by the index case, mark it as such
-							if(infectious == Index_Case){ ++ number_of_secondary_infections; }
+							// try to infect all the susceptibles in the flat
+							if(flatmate == infectious) { continue; } // can't be the same person
+							// must be susceptible to the infection (and not exposed already today)
+							if((NorthShore.Agent(flatmate).status() != 'S') or NorthShore.exposure_pending(flatmate)) { continue; }
+							if(randfloat(generator) < the_thresholds[NorthShore.Agent(flatmate).age() == 'A'])
+							{
+								expose(flatmate, Locale_Home, infectious);
+							}
 						}
 					}
 				}
 
 				// spreading the infection in the classroom
-				for(std::pair<int, std::set<int>> the_class : NorthShore.classrooms())
+				for(const int class_number : NorthShore.classroom_numbers())
 				{
-					// obvious, but we retrieve these lists of infectious and susceptible members here since they vary by classroom
-					std::vector<int> infectious_members, susceptible_members;
-					std::copy_if(
-						the_class.second.begin(),
-						the_class.second.end(),
-						std::back_inserter(infectious_members),
-						[&](int person){ return Infectious_Statuses.count(NorthShore.Agent(person).status()); }
-					);
-					std::copy_if(
-						the_class.second.begin(),
-						the_class.second.end(),
-						std::back_inserter(susceptible_members),
-						[&](int person){ return (NorthShore.Agent(person).status() == 'S'); }
-					);
+					if(class_number == -1){ continue; }
+					/*
+						the infectious and susceptible agents sitting in the class, as slots on its roster - a couple of ANDs on the
+							classroom's masks, with no looking up anyone's status (see Town::classroom_slots)
+					*/
+					const Agent_Range the_roster = NorthShore.classroom_roster(class_number);
+					const Agent_Group infectious_slots = NorthShore.classroom_slots(class_number, Infectious_Statuses);
+					const Agent_Group susceptible_slots = NorthShore.classroom_slots(class_number, {'S'});
 
 					// actually spread the infection
-					for(int inf : infectious_members){ for(int sus : susceptible_members){
-						const char Inf_Age = NorthShore.Agent(inf).age();
-						const char Sus_Age = NorthShore.Agent(sus).age();
-						// halve the in-school transmissions in the reduced hours scenario
-						if(randfloat(generator) < (1 - 0.5*(!!Reduced_Hours))*B_C*NorthShore.school_contact_rate(Inf_Age, Sus_Age))
-						{
-							NorthShore.set_status(sus, 'E', "class");
-							// if exposed to the index case, mark it as such
-							if(inf == Index_Case){ ++ number_of_secondary_infections; }
-						}
-					}}
+					if(Aggregate_School_Transmission)
+					{
+						spread_in_the_room(infectious_slots, susceptible_slots, [&](const int slot){ return the_roster[slot]; }, Place_Classroom, Locale_Class);
+					}
+					else
+					{
+						spread_pair_by_pair(infectious_slots, susceptible_slots, [&](const int slot){ return the_roster[slot]; }, Place_Classroom, Locale_Class);
+					}
 				}
 
 				// infection in the common area - so all agents just crawling all over each other
-				for(int inf : NorthShore.agents_in_school(Infectious_Statuses))
+				// (no one's in school on the weekend, see Town::agents_in_school, so there's nothing to do then)
+				if constexpr(not Weekend)
 				{
-					for(int sus : NorthShore.agents_in_school({'S'}))
+					if(Aggregate_School_Transmission)
+					{
+						spread_in_the_room(NorthShore.agents_in_school(Infectious_Statuses), NorthShore.agents_in_school({'S'}), [](const int agent){ return agent; }, Place_Commons, Locale_Commons);
+					}
+					else
 					{
 						// again using the age- and locale-specific contact rates
-						const char Inf_Age = NorthShore.Agent(inf).age();
-						const char Sus_Age = NorthShore.Agent(sus).age();
-						// halve the in-school transmissions in the reduced hours scenario
-						if(randfloat(generator) < (1 - 0.5*(!!Reduced_Hours))*B_0*NorthShore.school_contact_rate(Inf_Age, Sus_Age))
+						spread_pair_by_pair(NorthShore.agents_in_school(Infectious_Statuses), NorthShore.agents_in_school({'S'}), [](const int agent){ return agent; }, Place_Commons, Locale_Commons);
+					}
+				}
+			};
+
+			// in that case, intentionally infect someone in the school see what happens
+			do
+			{
+				// background infection (coffee shops, Walmart, Grindr hookups, you know the drill...)
+				if(Geometric_Skip_Sampling)
+				{
+					// straight to the few who catch it, among the susceptibles outside the school and those in it, each at their own rate
+					auto catch_it = [&](const int susceptible){ NorthShore.expose(susceptible, Locale_Background); };
+					for_each_sampled(NorthShore.agents_without_classroom('S'), Background_Infection_Not_in_School, generator, catch_it);
+					for_each_sampled(NorthShore.agents_with_classroom('S'), Background_Infection_in_School, generator, catch_it);
+				}
+				else
+				{
+					for(int susceptible : NorthShore.agents('S'))
+					{
+						// double the rate for individuals who do not go to the school
+						if(NorthShore.Agent(susceptible).classroom() == -1)
+						{
+							if(randfloat(generator) < Background_Infection_Not_in_School){ NorthShore.expose(susceptible, Locale_Background); }
+						}
+						else
 						{
-							NorthShore.set_status(sus, 'E', "commons");
-							// if exposed to the index case, mark it as such
-							if(inf == Index_Case){ ++ number_of_secondary_infections; }
+							// just the plain old exposure rate
+							if(randfloat(generator) < Background_Infection_in_School){ NorthShore.expose(susceptible, Locale_Background); }
 						}
 					}
 				}
+				// the people in the substitute households held in reserve are out of school, and catch it too
+				if(Substitute_Households_On_Demand){ NorthShore.expose_the_reserve(Background_Infection_Not_in_School); }
+
+				// the infection spreading between the agents, compiled separately for the weekend and the weekdays
+				if(NorthShore.currently_the_weekend()){ spread_the_infection(std::true_type()); }
+				else { spread_the_infection(std::false_type()); }
+
+				/*
+					all the exposures above were only asked for; they all happen now, in one go. nobody already asked for was tried
+						again where the old one-at-a-time loops wouldn't have (see exposure_pending), so the exposure that counts
+						for each agent is the first one asked for: background, then home, then the classroom, then the common area,
+						and within each in the order they were tried. that's who they're down as infected by
+					the index case is credited with every exposure of its own that was asked for, as always, whether or not it
+						counted (it can still lose out to someone else in the same classroom), unless only the ones that counted are
+						(see Count_Effective_Secondary_Infections)
+				*/
+				NorthShore.commit_changes();
+				if(Event_Driven_Progression){ schedule_the_arrivals(); }
+				if(Count_Effective_Secondary_Infections){ number_of_secondary_infections = NorthShore.num_infected_by(Index_Case); }
 
 				// increment the run time of the sim and record the results
 				++run_counter;
@@ -541,41 +825,39 @@ TIC(0);
 				NorthShore.advance_the_time();
 
 				/*
-					we store all the compartments first to make sure that agents aren't processed more than once,
-						that is, E->P->A all in one go because of how the transition operations are structured
-					alternately, the order of the transitions could just be reversed with the same effect
+					the status changes are also only asked for here, and made all at once afterwards, so no agent is moved along
+						more than once a day (E->P->A all in one go) however the transitions below are ordered
 				*/
-				const std::set<int> E_Agents = NorthShore.agents('E');
-				const std::set<int> P_Agents = NorthShore.agents('P');
-				const std::set<int> I_Agents = NorthShore.agents('I');
-				const std::set<int> A_Agents = NorthShore.agents('A');
-
-				// exposed (E) agents become presymptomatic (P)
-				for(int exposed : E_Agents){ if(randfloat(generator) < E_to_P_rate){ NorthShore.set_status(exposed, 'P'); } }
-				// presymptomatic (P) agents become either symptomatic (I) or asymptomatic (A)
-				for(int no_symp	: P_Agents)
+
+				if(Event_Driven_Progression)
 				{
-					if(randfloat(generator) < P_to_Inf_rate)
+					// just the agents due to move on today, each to wherever they go next
+					for(const int agent : NorthShore.transitions_due())
 					{
-						// children and adults have different probabilities of developing symptoms
-						if(NorthShore.Agent(no_symp).age() == 'C')
-						{
-							if(randfloat(generator) < Probability_of_Child_Developing_Symptoms){ NorthShore.set_status(no_symp, 'I'); }
-							else { NorthShore.set_status(no_symp, 'A'); }
-						}
-						else if(NorthShore.Agent(no_symp).age() == 'A')
+						NorthShore.change_status(agent, next_status(agent, status_index(NorthShore.Agent(agent).status())));
+					}
+				}
+				else
+				{
+					/*
+						each status in turn, in the order of the disease model (E->P, P->I or A, I->R, A->R): everyone in it moves on
+							with its rate, to wherever they go next
+					*/
+					for(const int state : Disease.progression)
+					{
+						for(int agent : NorthShore.compartment(Disease_Status_Names[state]))
 						{
-							if(randfloat(generator) < Probability_of_Adult_Developing_Symptoms){ NorthShore.set_status(no_symp, 'I'); }
-							else { NorthShore.set_status(no_symp, 'A'); }
+							if(randfloat(generator) < Disease.rate[state]){ NorthShore.change_status(agent, next_status(agent, state)); }
 						}
 					}
 				}
-				// symptomatically and asymptomatically infected agents recover/isolate at the given rates
-				for(int coughing : I_Agents){ if(randfloat(generator) < I_to_R_rate){ NorthShore.set_status(coughing, 'R'); } }
-				for(int fakewell : A_Agents){ if(randfloat(generator) < A_to_R_rate){ NorthShore.set_status(fakewell, 'R'); } }
+
+				// and everyone moves along together
+				NorthShore.commit_changes();
+				if(Event_Driven_Progression){ schedule_the_arrivals(); }
 
 			}
-			while((NorthShore.agents({'P', 'I', 'A', 'E'}).size() != 0) or (NorthShore.closed_classrooms().size() != 0));
+			while((NorthShore.num_active_infections() != 0) or (NorthShore.num_closed_classrooms() != 0));
 			// stopping criteria: All classrooms are open, and there is no possible infection spread in the population
 
 			// get the final state of the sim at the end
@@ -588,9 +870,6 @@ TIC(0);
 
 			// clear the local buffer for preparation for the next instance
 			std::stringstream().swap(local_output_buffer);
-
-			// reset the network before running the next parameter combination
-			NorthShore.reset();
 		}
 
 		// assemble the title line of the output CSV
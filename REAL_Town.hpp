@@ -8,21 +8,24 @@
 
 #include "REAL_Parameters_Helpers.hpp"
 #include "REAL_Person.hpp"
+#include "REAL_Town_Containers.hpp"
 #include <numeric>
 #include <cassert> // assertions to check the inputs to some of the functions
 #include <map>
+#include <array>
 #include <random>
+#include <sstream>
 
 std::random_device rd;
 std::mt19937 generator(rd());
 
-template<typename TK, typename TV> std::set<TK> extract_keys(std::map<TK, TV> const& input_map)
+template<typename TK, typename TV, typename... Rest> std::set<TK> extract_keys(std::map<TK, TV, Rest...> const& input_map)
 {
 	std::set<TK> retval;
 	for(auto const& element : input_map) retval.insert(element.first);
 	return retval;
 }
-template<typename TK, typename TV> std::set<TV> set_of_values(std::map<TK, TV> const& input_map)
+template<typename TK, typename TV, typename... Rest> std::set<TV> set_of_values(std::map<TK, TV, Rest...> const& input_map)
 {
 	std::set<TV> retval;
 	for(std::pair<TK, TV> const& element : input_map) retval.insert(element.second);
@@ -47,7 +50,7 @@ template<typename TV> std::set<TV> set_of_values(std::vector<std::vector<TV>> co
 // 	for(std::pair<TK, TV> const& element : input_map) retval.push_back(element.second);
 // 	return retval;
 // }
-template<typename TK, typename TV> int number_of_values(std::map<TK, TV> const& input_map)
+template<typename TK, typename TV, typename... Rest> int number_of_values(std::map<TK, TV, Rest...> const& input_map)
 {
 	int retval=0;
 	for(std::pair<TK, TV> const& element : input_map) retval += element.second.size();
@@ -60,37 +63,250 @@ template<typename TV> int number_of_values(std::vector<std::vector<TV>> const& i
 	return retval;
 }
 
+/*
+	The SEPAIR statuses are numbered so that they can index arrays (the disease compartments, for one).
+	They're numbered in alphabetical order, the order the compartments have always been printed in.
+*/
+const int Num_Disease_Statuses = 6;
+const char Disease_Status_Names[Num_Disease_Statuses] = {'A', 'E', 'I', 'P', 'R', 'S'};
+
+/*
+	The disease model (Disease_Model, in REAL_Parameters_Helpers.hpp) compiled into arrays indexed by the status number, so whatever
+		is asked about an agent's status in the busy parts of the code (can they pass it on? are they off sick?) is an array
+		load rather than a set lookup.
+	index_of - Index: the status (as a char). Value: its number, or -1 if it isn't a SEPAIR status
+	progression - the numbers of the statuses the agents move on from, in the order of the table
+*/
+struct Compiled_Disease_Model
+{
+	std::array<int, 256> index_of;
+	std::array<bool, Num_Disease_Statuses> infected;
+	std::array<bool, Num_Disease_Statuses> infectious;
+	std::array<bool, Num_Disease_Statuses> symptomatic;
+	std::array<bool, Num_Disease_Statuses> off_sick;
+	std::array<float, Num_Disease_Statuses> rate;
+	std::array<std::array<char, 2>, Num_Disease_Statuses> next;
+	std::array<std::array<float, 2>, Num_Disease_Statuses> chance_of_first_next;
+	std::vector<int> progression;
+};
+
+inline Compiled_Disease_Model compile_disease_model()
+{
+	Compiled_Disease_Model model;
+	model.index_of.fill(-1);
+	for(int state = 0; state < Num_Disease_Statuses; ++state){ model.index_of[(unsigned char)Disease_Status_Names[state]] = state; }
+
+	std::array<bool, Num_Disease_Statuses> have_row{};
+	for(const Disease_Status_Row& row : Disease_Model)
+	{
+		const int state = model.index_of[(unsigned char)row.status];
+		if( (state == -1) or have_row[state] or
+			(model.index_of[(unsigned char)row.next[0]] == -1) or (model.index_of[(unsigned char)row.next[1]] == -1) )
+		{
+			std::cerr << "###### THE DISEASE MODEL HAS A BAD ROW FOR STATUS '" << row.status << "'. ######" << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+		have_row[state] = true;
+
+		model.infected[state] = row.infected;
+		model.infectious[state] = row.infectious;
+		model.symptomatic[state] = row.symptomatic;
+		model.off_sick[state] = row.off_sick;
+		model.rate[state] = row.rate;
+		model.next[state] = {{row.next[0], row.next[1]}};
+		model.chance_of_first_next[state] = {{row.chance_of_first_next[0], row.chance_of_first_next[1]}};
+		if(row.rate > 0){ model.progression.push_back(state); }
+	}
+	for(int state = 0; state < Num_Disease_Statuses; ++state)
+	{
+		if(not have_row[state])
+		{
+			std::cerr << "###### THE DISEASE MODEL HAS NO ROW FOR STATUS '" << Disease_Status_Names[state] << "'. ######" << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+	}
+	return model;
+}
+
+inline const Compiled_Disease_Model Disease = compile_disease_model();
+
+const int status_index(const char status){ return Disease.index_of[(unsigned char)status]; }
+
+/*
+	Read-only view of the disease compartments that have been used: iterating over it gives (disease status, bitset of agents)
+		pairs in the same order the compartments are printed in. Nothing is copied.
+*/
+class Compartment_List_View
+{
+	private:
+
+		const std::array<Agent_Bitset, Num_Disease_Statuses>* _compartments;
+		const std::array<bool, Num_Disease_Statuses>* _in_use;
+
+	public:
+
+		typedef std::pair<char, const Agent_Bitset&> value_type;
+
+		class const_iterator
+		{
+			private:
+
+				const Compartment_List_View* _view;
+				int _state;
+
+				void skip_unused(){ while((_state < Num_Disease_Statuses) and (not (*_view->_in_use)[_state])){ ++_state; } }
+
+			public:
+
+				typedef std::forward_iterator_tag iterator_category;
+				typedef Compartment_List_View::value_type value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const value_type* pointer;
+				typedef value_type reference;
+
+				const_iterator(const Compartment_List_View* view, const int state) : _view(view), _state(state) { skip_unused(); }
+
+				value_type operator * () const { return value_type(Disease_Status_Names[_state], (*_view->_compartments)[_state]); }
+				const_iterator& operator ++ () { ++_state; skip_unused(); return *this; }
+				const_iterator operator ++ (int) { const_iterator old = *this; ++(*this); return old; }
+				bool operator == (const const_iterator& other) const { return _state == other._state; }
+				bool operator != (const const_iterator& other) const { return _state != other._state; }
+		};
+		typedef const_iterator iterator;
+
+		Compartment_List_View(const std::array<Agent_Bitset, Num_Disease_Statuses>* compartments, const std::array<bool, Num_Disease_Statuses>* in_use)
+			: _compartments(compartments), _in_use(in_use) {}
+
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, Num_Disease_Statuses); }
+};
+
+/*
+	The classrooms (who's assigned to each one, and who's sitting in it) never hold more than a full class from each cohort, its
+		teachers, and a substitute for each of the teachers, so they're kept in fixed-size lists inside the Town's own storage, with no
+		allocation for each classroom and all of a classroom's members next to each other. Compile with
+		-DTOWN_DYNAMIC_CLASSROOMS to go back to lists that can grow as big as they need to, for classes bigger than that.
+*/
+#ifndef TOWN_DYNAMIC_CLASSROOMS
+	const int Classroom_Capacity = Max_Child_Cohorts*Max_Children_per_Classroom + 2*Max_Teachers_per_Classroom;
+	typedef Numbered_Groups<Inline_Agent_List<Classroom_Capacity>> Classroom_Groups;
+#else
+	typedef Numbered_Groups<> Classroom_Groups;
+#endif
+
+/*
+	Bit masks over the places on one classroom's roster (its "slots": the first agent on the roster, in order of ID, is in slot 0,
+		and so on). A classroom is a few dozen agents, so each mask is a word or two, and finding who's sitting in class with
+		a given disease status is a handful of ANDs instead of a trip through the agent store for everyone in the room.
+
+	present - the slots of the agents sitting in the classroom (on the class list, see Town::classroom)
+	present_by_age - the same, split into children (index 0) and adults (index 1)
+	in_status - Index: disease status (status_index). Value: the slots of the agents on the roster with that status
+*/
+struct Classroom_Slots
+{
+	Agent_Bitset present;
+	std::array<Agent_Bitset, 2> present_by_age;
+	std::array<Agent_Bitset, Num_Disease_Statuses> in_status;
+
+	explicit Classroom_Slots(Town_Arena* arena)
+		: present(arena), present_by_age {{Agent_Bitset(arena), Agent_Bitset(arena)}},
+		  in_status {{Agent_Bitset(arena), Agent_Bitset(arena), Agent_Bitset(arena), Agent_Bitset(arena), Agent_Bitset(arena), Agent_Bitset(arena)}} {}
+};
+
+/*
+	Changes to the agents held over until the Town commits them (see Town::commit_changes): an exposure of a susceptible agent,
+		with where it happened and who was responsible (-1 for nobody in particular), or a move to the next disease status
+*/
+struct Pending_Exposure
+{
+	int agent;
+	Infection_Locale locale;
+	int source;
+
+	// field by field, so the padding after the locale stays out of a snapshot (see write_binary)
+	void serialize(std::ostream& out) const { write_binary(out, agent); write_binary(out, locale); write_binary(out, source); }
+	void deserialize(std::istream& in) { read_binary(in, agent); read_binary(in, locale); read_binary(in, source); }
+};
+struct Pending_Status_Change
+{
+	int agent;
+	char new_status;
+
+	void serialize(std::ostream& out) const { write_binary(out, agent); write_binary(out, new_status); }
+	void deserialize(std::istream& in) { read_binary(in, agent); read_binary(in, new_status); }
+};
+
+/*
+	One closure of one classroom, from the day it was shut to the day it reopened, with the student-days the children on its roster
+		missed while it was shut (the same children child_closure_days() counts, added up over the school days of the closure)
+*/
+struct Classroom_Closure
+{
+	int classroom;
+	int closed_on; // the day it was shut
+	int reopens_on; // the day it's due to reopen (it's still shut if that hasn't come yet)
+	int missed_student_days;
+};
+
 class Town
 {
 	private:
 
-		// Child-Adult contact matrices built using the Canada-specific household and school contact matrices given be Prem et. al. (2017)
-		std::map<std::pair<char, char>, float> _school_contact_matrix = { {{'C','C'}, 1.2355}, {{'C','A'}, 0.0589}, {{'A', 'C'}, 0.1176}, {{'A','A'}, 0.0451} };
-		std::map<std::pair<char, char>, float> _home_contact_matrix = { {{'C','C'}, 0.5378}, {{'C', 'A'}, 0.3916}, {{'A','C'}, 0.3632}, {{'A','A'}, 0.3335} };
+		/*
+			All the containers below allocate from this arena (see Town_Arena), so it has to be declared first: it's built before
+				them and destroyed after them, taking all their storage with it in one go. 64 KiB is about what a Town for one
+				instance of the simulation needs; the arena grows past that on its own if it has to.
+		*/
+		Town_Arena _arena {1 << 16};
 
-		// vector to hold all the persons in the simulation
-		std::vector<Person> _Population;
+		// the start of every snapshot (see serialize), and the version of the layout. bump the version when the Town's state changes
+		static constexpr char Snapshot_Tag[8] = {'R', 'E', 'A', 'L', 'T', 'O', 'W', 'N'};
+		static constexpr int Snapshot_Version = 5;
+
+		// characteristics of all the persons in the simulation, one contiguous array per characteristic
+		Agent_Store _agents {&_arena};
 		// vector to hold the numbers of all the agents in the simulation. used for iteration in loops
-		std::vector<int> _agent_IDs;
+		Town_Vector<int> _agent_IDs {&_arena};
+		/*
+			the number each agent was given when they were added to the Town, which stays the same when the agents are
+				renumbered (see renumber_agents_by_locality)
 
-		// these are the households; the key is the number of the household, and the value is the set of IDs of the agents in that flat
+			Index - agent ID
+			Value - the agent's number in order of creation
+		*/
+		Town_Vector<int> _external_IDs {&_arena};
+
+		// these are the households; for each household number, the IDs of the agents in that flat
 		// ex. household number 1: agents: 2, 5, 76, 9
-		std::map<int, std::set<int>> _households;
+		// the table is built from the agents' household characteristics once the population is made (see the_households())
+		Household_Table _households {&_arena};
+		// someone's moved in (or moved house) since the table was built
+		bool _households_out_of_date;
 
-		// this is the single school in the population; each classroom will have an assigned number and a set of student IDs
-		std::map<int, std::set<int>> _school;
+		// this is the single school in the population; each classroom will have an assigned number and a list of the IDs of the agents sitting in it
+		Classroom_Groups _school {&_arena};
 
 		/*
 			Their plan is, if there's an outbreak in a class, shut it down for 14 days.
 
-			Key - the number of the classroom
-			Value - the number of school days for which it has been shut down so far
+			The day a classroom is shut, the day it'll reopen is worked out there and then (14 days on, or the Monday after, if
+				that falls on a weekend), and the classroom is put in that day's slot of the timer wheel. advance_the_time just
+				empties today's slot, instead of counting every closure up one day at a time to see which have run out.
 
-			1) This structure will track the number of days for which the classroom was closed per closure.
-			2) Trying to print a shut down classroom will just give a "stay away if you want to live" message.
-			3) There will be a getter function that tells whether a particular room is shut down
+			_closure_ledger - every closure so far, in the order they happened (see Classroom_Closure)
+			_current_closure - Index: the number of the classroom. Value: its entry in the ledger if it's shut, or -1 if it's open
+			_num_closed_classrooms - the number of classrooms shut right now
+			_reopenings_due - the timer wheel. Index: day % Closure_Wheel_Size. Value: the classrooms reopening that day
+			_child_closure_days_so_far - child_closure_days added up over the days gone by, which the ledger's missed student-days
+				should add up to as well (see check_closure_ledger)
 		*/
-		std::map<int, int> _classroom_num_days_shut_down_due_to_illness;
+		static const int Closure_Wheel_Size = 21; // three weeks, more than the 16 days a closure can last (14, and a weekend)
+		Town_Vector<Classroom_Closure> _closure_ledger {&_arena};
+		Town_Vector<int> _current_closure {&_arena};
+		int _num_closed_classrooms;
+		Town_Vector<Town_Vector<int>> _reopenings_due {&_arena};
+		int _child_closure_days_so_far;
 
 		/*
 			Scenario: a teacher originally assigned to some room becomes ill and is sent home. They must be replaced.
@@ -108,13 +324,68 @@ class Town
 				them to their classroom number, sack their replacement (that is, remove them from the current classroom and set their
 				classroom characteristic to 0)
 		*/
-		std::map<int, int> _substitute_list_OGs_first;
+		Town_Map<int, int> _substitute_list_OGs_first {&_arena};
+		/*
+			The same list the other way around, so there's no need to search it to see whether someone's a substitute.
+
+			Index - agent ID
+			Value - the original teacher they're substituting for (-1 if they aren't a substitute)
+		*/
+		Town_Vector<int> _OG_teacher_of {&_arena};
+
+		/*
+			Everyone who could be hired as a substitute right now (see replace_sick_teacher): adults who aren't isolating, from
+				houses where nobody is assigned to a classroom. They're kept in order of (household number, ID), which is the order
+				the households used to be searched in, so the first one is the one that gets hired.
+
+			The pool is built along with the household table (see the_households()) and kept up to date by update_substitute_pool.
+
+			_num_assigned_to_school - Index: row of the household in the table. Value: number of its members assigned to a classroom
+			_assigned_a_classroom - agents counted in _num_assigned_to_school
+			_available_substitutes - the agents in the pool, so we can tell whether they're in it without looking
+		*/
+		std::set<std::pair<int, int>, std::less<std::pair<int, int>>, Town_Allocator<std::pair<int, int>>> _substitute_pool {&_arena};
+		Town_Vector<int> _num_assigned_to_school {&_arena};
+		Agent_Bitset _assigned_a_classroom {&_arena};
+		Agent_Bitset _available_substitutes {&_arena};
+
+		/*
+			Substitute households made on demand (see Substitute_Households_On_Demand): instead of making every household that
+				might one day supply a substitute when the town is built, we only write down who'd be in them (their ages, and
+				whether they've had it already), and make one into a real household when replace_sick_teacher runs out of
+				candidates, or when one of the people in it catches it in the community (see expose_the_reserve). Until then
+				they're still counted in the population (num_agents, num_age, num_households, agents_proportion), so the
+				proportions come out the same as if they'd all been made up front.
+
+			_reserve_ages, _reserve_statuses - the people in the households in reserve, one household after the other
+			_reserve_offsets - Index: household in reserve. Value: where its people start in _reserve_ages and _reserve_statuses
+				(the last entry is where the last household ends)
+			_reserve_made - Index: household in reserve. Value: whether it's been made into a real household yet
+			_substitute_households_in_reserve - number of households that can still be made
+			_reserve_in_status - Index: disease status (numbered by status_index). Value: how many of the people in the households
+				not made yet have it (only ever S or R)
+			_reserve_adults, _reserve_children - the makeup of the households not made yet
+			_reserve_generator - random numbers for the households in reserve, on their own stream seeded from the instance's
+				seed, so the same instance always makes the same households no matter when they're needed
+		*/
+		Town_Vector<char> _reserve_ages {&_arena};
+		Town_Vector<char> _reserve_statuses {&_arena};
+		Town_Vector<int> _reserve_offsets {&_arena};
+		Town_Vector<char> _reserve_made {&_arena};
+		int _substitute_households_in_reserve;
+		std::array<int, Num_Disease_Statuses> _reserve_in_status;
+		int _reserve_adults;
+		int _reserve_children;
+		std::mt19937 _reserve_generator;
 
 		/*
 			set of agents for every disease state - this makes it easier to find specifically the infected nodes, for example
 
-			Key - disease state (one of S, E, P, A, I, R)
-			Value - set of IDs of the agents currently in that stage of disease progression
+			Index - disease state (one of S, E, P, A, I, R), numbered by status_index
+			Value - bitset of the IDs of the agents currently in that stage of disease progression
+
+			Moving an agent between compartments is two bit flips, and the agents() functions hand out views over these bitsets
+				rather than building new sets.
 
 			this way, we don't need to keep traversing the list of all agents each time we're looking for a specific subgroup.
 
@@ -127,13 +398,11 @@ class Town
 				R - removed/recuperating/recovered - they spend 14 days in isolation, then recover and go back to school/work like normal
 				    ("What? COVID-19? I don't know her."...)
 		*/
-		std::map<char, std::set<int>> _disease_compartments;
-
-		/*
-			The set of allowable disease statuses in the model. For error checks, I'll assert that disease statuses in the sim must be
-				a member of this set. Else, fail.
-		*/
-		const std::set<char> _disease_statuses = {'S', 'E', 'P', 'I', 'A', 'R'};
+		std::array<Agent_Bitset, Num_Disease_Statuses> _disease_compartments {{
+			Agent_Bitset(&_arena), Agent_Bitset(&_arena), Agent_Bitset(&_arena), Agent_Bitset(&_arena), Agent_Bitset(&_arena), Agent_Bitset(&_arena)
+		}};
+		// whether anyone has ever been put in each compartment - empty compartments that were never used aren't printed
+		std::array<bool, Num_Disease_Statuses> _compartment_in_use;
 
 		/*
 			A counter of the number of the days in the simulation
@@ -168,28 +437,539 @@ class Town
 				Third week:		Teacher: Comrade Ogilvy,	Students: cohort 1
 				und so weiter...
 		*/
-		std::map<int, std::set<int>> _the_cohorts;
+		Numbered_Groups<> _the_cohorts {&_arena};
 
 		/*
 			This structure keeps track of where exactly each node got infected; it'd be nice to know which places are the most dangerous
 
-			Key: the specific location in the model: household ("home"), classroom ("class"), common areas ("commons"), community infection ("background")
-			Value: a set giving the IDs of all the agents infected at that site
+			Index: the specific location in the model: household (Locale_Home), classroom (Locale_Class), common areas (Locale_Commons),
+				community infection (Locale_Background)
+			Value: a bitset giving the IDs of all the agents infected at that site (it keeps its own count, so locale_infections() is free)
 
 			Agents are entered in here when they become exposed (status E).
 			The index case is given status P, so we don't care about them; that just happened.
 		*/
-		std::map<std::string, std::set<int>> _places_infected;
+		std::array<Agent_Bitset, Num_Infection_Locales> _places_infected {{
+			Agent_Bitset(&_arena), Agent_Bitset(&_arena), Agent_Bitset(&_arena), Agent_Bitset(&_arena), Agent_Bitset(&_arena), Agent_Bitset(&_arena)
+		}};
+
+		/*
+			Everyone assigned to each classroom, whether or not they're actually sitting in it today (sick teachers, children
+				isolating at home and the cohort that's off this week all stay on the roster).
+
+			Index - the number of the classroom
+			Value - list of IDs of the agents with that classroom characteristic
+		*/
+		Classroom_Groups _class_rosters {&_arena};
+
+		/*
+			The bit masks of every classroom (see Classroom_Slots), kept up to date along with the class lists, the rosters and
+				the agents' disease statuses.
 
-		// list of all the valid infection locations in the model
-		const std::set<std::string> _infection_places = {"background", "home", "class", "commons"};
+			_classroom_slots - Index: the number of the classroom. Value: its masks
+			_roster_slot - Index: agent ID. Value: their slot on the roster of their classroom (-1 if they're not on one)
+		*/
+		Town_Vector<Classroom_Slots> _classroom_slots {&_arena};
+		Town_Vector<int> _roster_slot {&_arena};
+
+		/*
+			The agents that would be in school on a school day: assigned to a classroom that's open, not isolating, and either in
+				this week's cohort or in cohort 0.
+
+			It's kept up to date by every function that changes one of those things (classrooms, cohorts, isolation counters,
+				closures and reopenings, the weekly cohort swap), so agents_in_school() doesn't have to go looking through
+				the whole population every time it's called.
+		*/
+		Agent_Bitset _school_attendees {&_arena};
+
+		/*
+			Running counts for the numbers written out every time step, updated along with the things they count
+				so that nobody has to go through the whole population to get them.
+
+			_num_in_school - Index: disease status (status_index). Value: number of school attendees with that status
+			_children_kept_home - children in this week's cohort who'd be fit for class, but whose classroom is shut (child_closure_days)
+			_num_adults, _num_children - the makeup of the population
+		*/
+		std::array<int, Num_Disease_Statuses> _num_in_school;
+		Agent_Bitset _children_kept_home {&_arena};
+
+		/*
+			The symptomatic and recovered (I and R) agents that advance_the_time still has something to do for: their symptom
+				counter is still running, or they're assigned to a classroom and waiting to get back into it (children who aren't
+				in the class list, original teachers whose substitute hasn't been sacked yet). See isolation_in_progress.
+
+			Everyone else in I and R would be passed over every day, and R only grows - R_init puts a tenth of the town in it
+				on day 0 - so advance_the_time goes through these instead. Agents leave once they're back in class, and are put
+				back whenever they might need bringing back again (when their classroom is emptied, or their counter is restarted).
+		*/
+		Agent_Bitset _isolation_in_progress {&_arena};
+
+		// everyone assigned to a classroom (teachers and children, whether they're in class today or not), see assign_classroom
+		Agent_Bitset _has_a_classroom {&_arena};
+
+		/*
+			The infection pressure in every household: how many of the people living there can pass it on at home, that is, are
+				infectious (P, I or A) and not isolating. Kept up to date as agents change status, start or finish isolating and
+				move house, so home transmission only has to look at the households with anyone spreading it.
+
+			_spreading_at_home - the agents counted in the pressure of their household
+			_home_pressure - Index: household number. Value: the number of children (index 0) and adults (index 1) spreading it there
+			_households_under_pressure - the numbers of the households with anyone spreading it (a set of household numbers, not agents)
+		*/
+		Agent_Bitset _spreading_at_home {&_arena};
+		Town_Vector<std::array<int, 2>> _home_pressure {&_arena};
+		Agent_Bitset _households_under_pressure {&_arena};
+
+		/*
+			Exposures and status changes asked for since the last commit_changes(), waiting to be made in one go.
+
+			While they're waiting, the Town doesn't change, so every part of the day loop that's looking for people to infect (or
+				to move along to the next status) sees the same "today", no matter what order the parts run in or what they find;
+				there's no need to take copies of the compartments to stop agents being moved two steps in one day either.
+
+			_exposure_pending - the agents with an exposure waiting (see exposure_pending)
+		*/
+		Town_Vector<Pending_Exposure> _pending_exposures {&_arena};
+		Town_Vector<Pending_Status_Change> _pending_status_changes {&_arena};
+		Agent_Bitset _exposure_pending {&_arena};
+
+		/*
+			The disease progression run as a schedule (see schedule_transition): instead of rolling the dice for every E, P, I
+				and A agent every day, the simulation works out how long each agent will stay in their new status as soon as they
+				get there, and the Town keeps them in the bucket of the day they're due to move on.
+
+			_recording_arrivals - whether set_status notes down the agents whose status changes (in _arrivals)
+			_arrivals - the agents whose status has changed since the simulation last looked (see status_arrivals)
+			_transition_day - Index: agent ID. Value: the day their next transition is due (-1 if none is scheduled)
+			_transitions_due - Index: day. Value: the agents due to move on that day, in the order they were scheduled. an agent
+				whose status has changed some other way since then is left in the bucket, but isn't due anymore (see transitions_due)
+		*/
+		bool _recording_arrivals;
+		Town_Vector<int> _arrivals {&_arena};
+		Town_Vector<int> _transition_day {&_arena};
+		Town_Vector<Town_Vector<int>> _transitions_due {&_arena};
+
+		// scratch lists for advance_the_time, kept here so they don't have to be allocated every day
+		Town_Vector<int> _classes_to_reopen {&_arena};
+		Town_Vector<int> _reopening_roster {&_arena};
+		int _num_adults;
+		int _num_children;
+
+		/*
+			recheck whether the agent should be counted as a school attendee, and whether they're a child missing school
+				because their classroom was shut
+		*/
+		void update_school_attendance(const int agent)
+		{
+			const int classr = _agents._classroom[agent];
+			const int cohort = _agents._cohort[agent];
+			const char status = _agents._disease_status[agent];
+
+			const bool attending = (
+				(classr != -1) and // assigned to a room in the centre
+				(not classroom_closed_due_to_infection(classr)) and // classroom open
+				(not is_in_isolation(agent)) and // must be healthy and fit to be in class
+				((cohort == this_weeks_cohort()) or (cohort == 0)) // in this week's cohort
+			);
+			if(attending != _school_attendees.contains(agent))
+			{
+				if(attending){ _school_attendees.insert(agent); ++ _num_in_school[status_index(status)]; }
+				else { _school_attendees.erase(agent); -- _num_in_school[status_index(status)]; }
+			}
+
+			const bool kept_home = (
+				(_agents._age[agent] == 'C') and // must be a child
+				(classr != -1) and // must be assigned a classroom
+				(not (is_in_isolation(agent) and Disease.off_sick[status_index(status)])) and // not isolating **due to illness**
+				classroom_closed_due_to_infection(classr) and // their classroom should be closed
+				(cohort == this_weeks_cohort()) // it doesn't count if their cohort isn't the one in class this week anyway
+			);
+			if(kept_home){ _children_kept_home.insert(agent); }
+			else { _children_kept_home.erase(agent); }
+
+			// going into (or coming out of) isolation, or changing classrooms, changes whether they can be hired as a substitute
+			update_substitute_pool(agent);
+		}
+
+		// put the agent in the substitute pool, or take them out, depending on whether they could be hired right now
+		void recheck_substitute(const int agent)
+		{
+			const int house = _agents._household[agent];
+			const bool available = (
+				(_agents._age[agent] == 'A') and // must be adult
+				(_num_assigned_to_school[_households.row(house)] == 0) and // no one from their house is assigned to the school
+				(not is_in_isolation(agent)) // asymptomatic or fully recovered
+			);
+			if(available == _available_substitutes.contains(agent)){ return; }
+			if(available){ _available_substitutes.insert(agent); _substitute_pool.insert({house, agent}); }
+			else { _available_substitutes.erase(agent); _substitute_pool.erase({house, agent}); }
+		}
+
+		// recheck the agent after their classroom or isolation changed (and their whole house, if it's now (in)eligible)
+		void update_substitute_pool(const int agent)
+		{
+			// the pool is built from scratch with the household table, so there's nothing to keep up to date until then
+			if(_households_out_of_date){ return; }
+
+			const bool assigned = (_agents._classroom[agent] != -1);
+			if(assigned != _assigned_a_classroom.contains(agent))
+			{
+				const int house = _agents._household[agent];
+				int& num_assigned = _num_assigned_to_school[_households.row(house)];
+				if(assigned){ _assigned_a_classroom.insert(agent); ++ num_assigned; }
+				else { _assigned_a_classroom.erase(agent); -- num_assigned; }
+
+				// the first one in or the last one out makes a difference to the whole household
+				if(num_assigned == (assigned ? 1 : 0))
+				{
+					for(const int member : _households.members(house)){ recheck_substitute(member); }
+					return;
+				}
+			}
+			recheck_substitute(agent);
+		}
+
+		// start the substitute pool over, from the household table
+		void build_substitute_pool()
+		{
+			_num_assigned_to_school.assign(_households.num_rows(), 0);
+			_assigned_a_classroom.clear();
+			_available_substitutes.clear();
+			_substitute_pool.clear();
+			for(const int agent : _agent_IDs)
+			{
+				if(_agents._classroom[agent] == -1){ continue; }
+				_assigned_a_classroom.insert(agent);
+				++ _num_assigned_to_school[_households.row(_agents._household[agent])];
+			}
+			for(const int agent : _agent_IDs){ recheck_substitute(agent); }
+		}
+
+		// whether advance_the_time still has something to do for the agent (see _isolation_in_progress)
+		const bool isolation_in_progress(const int agent) const
+		{
+			if(not Disease.off_sick[status_index(_agents._disease_status[agent])]){ return false; }
+
+			// the symptom counter is still running
+			const int days_since_first_symptoms = _agents._days_since_first_symptoms[agent];
+			if((days_since_first_symptoms > -1) and (days_since_first_symptoms < 14)){ return true; }
+
+			// they'll be brought back to class (or rehired) once they can
+			const int classr = _agents._classroom[agent];
+			if(classr == -1){ return false; }
+			if(_agents._age[agent] == 'C'){ return not _school.contains(classr, agent); }
+			return _substitute_list_OGs_first.count(agent) != 0;
+		}
+
+		// shut the classroom today, and put it down to reopen once the 14 days are up (on the Monday after, if that's a weekend)
+		void close_classroom(const int classr)
+		{
+			assert(not classroom_closed_due_to_infection(classr));
+			int reopens_on = _run_time + 14;
+			if(reopens_on%7 >= 5){ reopens_on += 7 - reopens_on%7; }
+
+			if(classr >= (int)_current_closure.size()){ _current_closure.resize(classr+1, -1); }
+			_current_closure[classr] = _closure_ledger.size();
+			_closure_ledger.push_back({classr, _run_time, reopens_on, 0});
+			++ _num_closed_classrooms;
+			_reopenings_due[reopens_on%Closure_Wheel_Size].push_back(classr);
+		}
+
+		// take the classroom off the closed list (the children are brought back by advance_the_time)
+		void open_classroom(const int classr)
+		{
+			assert(classroom_closed_due_to_infection(classr));
+			_current_closure[classr] = -1;
+			-- _num_closed_classrooms;
+		}
+
+		// add today's missed student-days to the ledger entry of every classroom that's shut (see child_closure_days)
+		void record_missed_student_days()
+		{
+			if(currently_the_weekend()){ return; }
+			for(int classr = 0; classr < (int)_current_closure.size(); ++classr)
+			{
+				if(_current_closure[classr] == -1){ continue; }
+				int& missed_student_days = _closure_ledger[_current_closure[classr]].missed_student_days;
+				for(const int agent : _class_rosters.members(classr)){ missed_student_days += _children_kept_home.contains(agent); }
+			}
+		}
+
+		// put the I and R agents on the classroom's roster back on the isolation list (when the classroom is emptied)
+		void recheck_isolation_in_progress(const int classr)
+		{
+			for(const int agent : _class_rosters.members(classr)){ if(isolation_in_progress(agent)){ _isolation_in_progress.insert(agent); } }
+		}
+
+		// change the classroom the agent is assigned to (just the characteristic - the rosters and class lists are up to the caller)
+		void assign_classroom(const int agent, const int classr)
+		{
+			_agents._classroom[agent] = classr;
+			if(classr != -1){ _has_a_classroom.insert(agent); }
+			else { _has_a_classroom.erase(agent); }
+		}
+
+		// whether the agent can pass the infection on to their flatmates today
+		const bool spreading_at_home(const int agent) const
+		{
+			return Disease.infectious[status_index(_agents._disease_status[agent])] and (not is_in_isolation(agent));
+		}
+
+		// count the agent in (or out of) the pressure of the given household
+		void add_home_pressure(const int agent, const int house, const int change)
+		{
+			assert(house >= 0);
+			if(house >= (int)_home_pressure.size())
+			{
+				_home_pressure.resize(house+1, {{0, 0}});
+				_households_under_pressure.resize(house+1);
+			}
+			_home_pressure[house][_agents._age[agent] == 'A'] += change;
+			if(_home_pressure[house][0] + _home_pressure[house][1] > 0){ _households_under_pressure.insert(house); }
+			else { _households_under_pressure.erase(house); }
+		}
+
+		// recheck whether the agent is spreading the infection at home (after their status or isolation might have changed)
+		void recheck_home_pressure(const int agent)
+		{
+			const bool spreading = spreading_at_home(agent);
+			if(spreading == _spreading_at_home.contains(agent)){ return; }
+			if(spreading){ _spreading_at_home.insert(agent); }
+			else { _spreading_at_home.erase(agent); }
+			add_home_pressure(agent, _agents._household[agent], spreading ? 1 : -1);
+		}
+
+		// work out the pressure in every household from scratch
+		void rebuild_home_pressure()
+		{
+			_spreading_at_home.reset();
+			_spreading_at_home.resize(_agents.size());
+			_home_pressure.clear();
+			_households_under_pressure.reset();
+			for(int agent = 0; agent < _agents.size(); ++agent){ recheck_home_pressure(agent); }
+		}
+
+		// number the agents on the classroom's roster again, and set up its masks from scratch (when someone joins or leaves it)
+		void rebuild_classroom_slots(const int classr)
+		{
+			if(classr == -1){ return; }
+			while(classr >= (int)_classroom_slots.size()){ _classroom_slots.emplace_back(&_arena); }
+
+			Classroom_Slots& slots = _classroom_slots[classr];
+			const Agent_Range roster = _class_rosters.members(classr);
+			for(Agent_Bitset* mask : {&slots.present, &slots.present_by_age[0], &slots.present_by_age[1]}){ mask->clear(); mask->resize(roster.size()); }
+			for(Agent_Bitset& mask : slots.in_status){ mask.clear(); mask.resize(roster.size()); }
+
+			for(int slot = 0; slot < roster.size(); ++slot)
+			{
+				const int agent = roster[slot];
+				_roster_slot[agent] = slot;
+				slots.in_status[status_index(_agents._disease_status[agent])].insert(slot);
+				if(_school.contains(classr, agent))
+				{
+					slots.present.insert(slot);
+					slots.present_by_age[_agents._age[agent] == 'A'].insert(slot);
+				}
+			}
+		}
+
+		// set up the slots and masks of every classroom from scratch, from the rosters, the class lists and the statuses
+		void rebuild_all_classroom_slots()
+		{
+			_roster_slot.assign(_agents.size(), -1);
+			for(const int classr : _class_rosters.numbers()){ rebuild_classroom_slots(classr); }
+		}
+
+		// take the agent off the classroom's roster, or put them on it (and renumber its slots)
+		void remove_from_roster(const int classr, const int agent)
+		{
+			_class_rosters.erase(classr, agent);
+			_roster_slot[agent] = -1;
+			rebuild_classroom_slots(classr);
+		}
+		void add_to_roster(const int classr, const int agent)
+		{
+			_class_rosters.insert(classr, agent);
+			rebuild_classroom_slots(classr);
+		}
+
+		// put the agent on the class list of the classroom (they have to be on its roster), or take them off it
+		void seat(const int classr, const int agent)
+		{
+			_school.insert(classr, agent);
+			if(classr == -1){ return; }
+			const int slot = _roster_slot[agent];
+			assert((slot != -1) and (_class_rosters.members(classr)[slot] == agent));
+			_classroom_slots[classr].present.insert(slot);
+			_classroom_slots[classr].present_by_age[_agents._age[agent] == 'A'].insert(slot);
+		}
+		void unseat(const int classr, const int agent)
+		{
+			_school.erase(classr, agent);
+			if((classr == -1) or (_roster_slot[agent] == -1)){ return; }
+			const int slot = _roster_slot[agent];
+			_classroom_slots[classr].present.erase(slot);
+			_classroom_slots[classr].present_by_age[_agents._age[agent] == 'A'].erase(slot);
+		}
+
+		// clear the class list of the classroom (everyone's sent home)
+		void empty_classroom(const int classr)
+		{
+			_school.clear(classr);
+			if((classr == -1) or (classr >= (int)_classroom_slots.size())){ return; }
+			_classroom_slots[classr].present.clear();
+			_classroom_slots[classr].present_by_age[0].clear();
+			_classroom_slots[classr].present_by_age[1].clear();
+		}
+
+		// recheck everyone on the roster of the classroom (when it closes or reopens)
+		void update_classroom_attendance(const int classr)
+		{
+			for(const int agent : _class_rosters.members(classr)){ update_school_attendance(agent); }
+		}
+
+		// recheck everyone assigned to any classroom (when the cohorts swap)
+		void update_all_school_attendance()
+		{
+			for(const int classr : _class_rosters.numbers()){ update_classroom_attendance(classr); }
+		}
+
+		/*
+			give every agent a new ID (new_number_of[old ID] = new ID) and move everything the Town knows about them along with them
+
+			only the order of the agents in memory changes; agent number new_number_of[x] afterwards is the same person agent x was
+				before, with the same household, classroom, cohort, disease status, etc., and the same external ID
+		*/
+		void renumber_agents(const std::vector<int>& new_number_of)
+		{
+			assert((int)new_number_of.size() == _agents.size());
+			assert(_pending_exposures.empty() and _pending_status_changes.empty());
+
+			_agents.renumber(new_number_of);
+			Agent_Store::permute(_external_IDs, new_number_of);
+			_households_out_of_date = true;
+
+			_school.renumber(new_number_of);
+			_the_cohorts.renumber(new_number_of);
+			_class_rosters.renumber(new_number_of);
+
+			for(Agent_Bitset& the_compartment : _disease_compartments){ the_compartment.renumber(new_number_of); }
+			for(Agent_Bitset& the_place : _places_infected){ the_place.renumber(new_number_of); }
+			_school_attendees.renumber(new_number_of);
+			_children_kept_home.renumber(new_number_of);
+			_isolation_in_progress.renumber(new_number_of);
+			_exposure_pending.renumber(new_number_of);
+			_has_a_classroom.renumber(new_number_of);
+			Agent_Store::permute(_transition_day, new_number_of);
+			for(int& agent : _arrivals){ agent = new_number_of[agent]; }
+			for(Town_Vector<int>& the_day : _transitions_due){ for(int& agent : the_day){ agent = new_number_of[agent]; } }
+			_spreading_at_home.renumber(new_number_of);
+			// everyone's place on their roster follows their new number, so all the masks are set up again
+			rebuild_all_classroom_slots();
+
+			Town_Map<int, int> renumbered_substitutes {&_arena};
+			for(const std::pair<int, int> the_pair : _substitute_list_OGs_first){ renumbered_substitutes[new_number_of[the_pair.first]] = new_number_of[the_pair.second]; }
+			_substitute_list_OGs_first.swap(renumbered_substitutes);
+			std::fill(_OG_teacher_of.begin(), _OG_teacher_of.end(), -1);
+			for(const std::pair<int, int> the_pair : _substitute_list_OGs_first){ _OG_teacher_of[the_pair.second] = the_pair.first; }
+			// the substitute pool goes out of date with the households, and is built again along with them
+		}
+
+		// the household table, (re)built from the agents' household characteristics if anyone has moved in since it was last built
+		const Household_Table& the_households()
+		{
+			if(_households_out_of_date)
+			{
+				_households.build(_agents._household);
+				_households_out_of_date = false;
+				build_substitute_pool();
+			}
+			return _households;
+		}
+
+		// view of the attendees in the given disease statuses (or all of them, if none are given)
+		template<typename Status_Collection> const Agent_Group attendees_in_states(const Status_Collection& the_statuses) const
+		{
+			Agent_Group the_attendees;
+			// no one's in school on the weekend
+			if(currently_the_weekend()){ return the_attendees; }
+			// everyone in school, regardless of disease status
+			if(the_statuses.size() == 0)
+			{
+				the_attendees.add(&_school_attendees);
+				return the_attendees;
+			}
+			for(const char one_state : the_statuses)
+			{
+				assert(check_disease_status(one_state));
+				the_attendees.add(&_disease_compartments[status_index(one_state)]);
+			}
+			the_attendees.restrict_to(&_school_attendees);
+			return the_attendees;
+		}
 
 		// check functions for assert statements - making sure I didn't do anything stupid
-		bool check_agent_number(const int index) const { return (index >= 0) & (index <= _Population.size()); } // checks that the agent with that number exists
-		bool check_disease_status(const char state) const { return (_disease_statuses.count(state) != 0); } // checks that the agent has a SEPAIR disease status
-		bool check_infection_locale(const std::string place) const { return (_infection_places.count(place) != 0); } // checks that the place infected is one of the allowed options
-		bool check_cohort_number(const int person) const { return _Population[person].cohort() != -1; } // allowed cohort number
-		bool check_classroom_status(const int classr){ return true; }
+		bool check_agent_number(const int index) const { return (index >= 0) & (index <= _agents.size()); } // checks that the agent with that number exists
+		bool check_disease_status(const char state) const { return (status_index(state) != -1); } // checks that the agent has a SEPAIR disease status
+		bool check_infection_locale(const Infection_Locale place) const { return (place >= Locale_Background) & (place <= Locale_Commons); } // checks that the place infected is one of the allowed options
+		bool check_cohort_number(const int person) const { return _agents._cohort[person] != -1; } // allowed cohort number
+		bool check_classroom_status(const int classr) const { return true; }
+
+		// the first one in the substitute pool is who the old search through every household would have hired (see replace_sick_teacher)
+		bool check_substitute_pool() const
+		{
+			if(_households_out_of_date){ return true; } // the pool is only built with the household table
+			int first_found = -1;
+			for(const int house : _households.numbers())
+			{
+				// if anyone in this house is assigned a spot in the school, move on to another house
+				bool skip_to_next_house = false;
+				for(const int person : _households.members(house)){ if(_agents._classroom[person] != -1){ skip_to_next_house = true; break; } }
+				if(skip_to_next_house){ continue; }
+				for(const int adult : _households.members(house))
+				{
+					if((_agents._age[adult] == 'A') and (not is_in_isolation(adult))){ first_found = adult; break; }
+				}
+				if(first_found != -1){ break; }
+			}
+			return first_found == (_substitute_pool.empty() ? -1 : _substitute_pool.begin()->second);
+		}
+		// the missed student-days in the ledger add up to child_closure_days of every day gone by (see record_missed_student_days)
+		bool check_closure_ledger() const
+		{
+			int ledger_total = 0;
+			for(const Classroom_Closure& closure : _closure_ledger){ ledger_total += closure.missed_student_days; }
+			return ledger_total == _child_closure_days_so_far;
+		}
+
+		// the pressure kept for every household is what counting everyone spreading it at home all over again gives (see recheck_home_pressure)
+		bool check_home_pressure() const
+		{
+			std::map<int, std::array<int, 2>> recount;
+			for(const int agent : _agent_IDs)
+			{
+				if(spreading_at_home(agent) != _spreading_at_home.contains(agent)){ return false; }
+				if(spreading_at_home(agent)){ ++ recount[_agents._household[agent]][_agents._age[agent] == 'A']; }
+			}
+			for(int house = 0; house < (int)_home_pressure.size(); ++house)
+			{
+				const std::array<int, 2> counted = recount.count(house) ? recount[house] : std::array<int, 2> {{0, 0}};
+				if(_home_pressure[house] != counted){ return false; }
+				if(_households_under_pressure.contains(house) != (counted[0] + counted[1] > 0)){ return false; }
+				recount.erase(house);
+			}
+			return recount.empty(); // and nobody's spreading it in a household the table hasn't got to
+		}
+
+		// nobody advance_the_time still has something to do for is missing from its list (see _isolation_in_progress)
+		bool check_isolation_in_progress() const
+		{
+			for(const int agent : _agent_IDs)
+			{
+				if(isolation_in_progress(agent) and (not _isolation_in_progress.contains(agent))){ return false; }
+			}
+			return true;
+		}
 
 		/*
 			If a teacher from the school falls ill, they must be replaced. This functions goes through the entire network searching
@@ -205,52 +985,23 @@ class Town
 			assert(check_agent_number(sick_teacher));
 
 			// sanity checks to see that the original teacher is an adult, and currently assigned to a classroom
-			assert(_Population[sick_teacher].age() == 'A');
-			assert(_Population[sick_teacher].classroom() != -1);
+			assert(_agents._age[sick_teacher] == 'A');
+			assert(_agents._classroom[sick_teacher] != -1);
 
 			// check that the teacher has actually been "sent home"
 			assert(is_in_isolation(sick_teacher));
 
 			/*
-				This variable holds the candidate for substitute teacher. We'll pull an agent and then check the criteria
-					one by one. If any fail, we pull another agent, rinse and repeat. If enough households were not generated,
-					it's possible that no substitutes can be found that fit the given criteria. So, if this number is still -1
-					at the end of the loop, print a big ass warning and rage quit the entire simulation like a true legend.
+				The substitute is the first adult in the pool (see _substitute_pool): the lowest-numbered house with no one assigned
+					to the school, and the first adult in it who isn't isolating. If enough households were not generated, it's
+					possible that no substitutes can be found that fit the given criteria. So, if the pool is empty, print a big
+					ass warning and rage quit the entire simulation like a true legend.
 			*/
-			int substitute_teacher = -1;
-
-			// find teacher households - in a suitable house, everyone should have classroom -1
-			for(std::pair<int, std::set<int>> the_pair : _households)
-			{
-				// if anyone in this house is assigned a spot in the school, move on to another house
-				bool skip_to_next_house = false;
-				for(int person : the_pair.second)
-				{
-					if(_Population[person].classroom() != -1)
-					{
-						skip_to_next_house = true;
-						break;
-					}
-				}
-				if(skip_to_next_house) continue;
-
-				/*
-					Now that we've found a viable house to exploit, find each adult in the house and see if they're isolating.
-					If we find a single asymptomatic adult, hallelujah, accept the candidate substitute and move on.
-				*/
-				for(int adult : adults_in_household(the_pair.first))
-				{
-					if(not is_in_isolation(adult))
-					{
-						substitute_teacher = adult;
-						break;
-					}
-				}
-
-				// if we haven't found a substitute yet, skip to the next house
-				if(substitute_teacher == -1){ continue; }
-				else { break; }
-			}
+			the_households(); // makes sure the pool has been built
+			// keep making substitute households (if there are any left to make) until one of them turns up someone fit to teach
+			while(_substitute_pool.empty() and (_substitute_households_in_reserve > 0)){ make_substitute_household(); }
+			assert(check_substitute_pool());
+			const int substitute_teacher = _substitute_pool.empty() ? -1 : _substitute_pool.begin()->second;
 
 			// If we've gone through all the houses and still haven't found a substitute, quit.
 			if(substitute_teacher == -1)
@@ -263,50 +1014,83 @@ class Town
 			}
 
 			// get the classroom that the original (now sick) teacher was assigned to. we'll remove and replace them.
-			const int classroom_needing_a_new_teacher = _Population[sick_teacher].classroom();
+			const int classroom_needing_a_new_teacher = _agents._classroom[sick_teacher];
 
 			// if they themselves were a substitute, find the original teacher that they were subbing for and mark the new sub as temping for the original one
-			if( set_of_values(_substitute_list_OGs_first).count(sick_teacher) )
+			if( is_substitute(sick_teacher) )
 			{
-				int OG_teacher = -1;
+				// who they were subbing for
+				const int OG_teacher = _OG_teacher_of[sick_teacher];
 
-				// find who they were subbing for
-				for(std::pair<int, int> the_pair : _substitute_list_OGs_first)
-				{
-					if(the_pair.second==sick_teacher)
-					{
-						OG_teacher = the_pair.first;
-						break;
-					}
-				}
 				// mark them as a replacement
 				_substitute_list_OGs_first[OG_teacher] = substitute_teacher;
-				_Population[sick_teacher].set_classroom(-1);
+				_OG_teacher_of[sick_teacher] = -1;
+				_OG_teacher_of[substitute_teacher] = OG_teacher;
+				assign_classroom(sick_teacher, -1);
+				remove_from_roster(classroom_needing_a_new_teacher, sick_teacher);
+				update_school_attendance(sick_teacher);
 			}
 			else // they themselves *are* the original teacher
 			{
-				assert(not extract_keys(_substitute_list_OGs_first).count(sick_teacher));
-				assert(not set_of_values(_substitute_list_OGs_first).count(sick_teacher));
+				assert(not _substitute_list_OGs_first.count(sick_teacher));
 
 				// note their substitute
 				_substitute_list_OGs_first[sick_teacher] = substitute_teacher;
+				_OG_teacher_of[substitute_teacher] = sick_teacher;
 			}
 
 			// sent the sick teacher home by taking them out of their classes
-			_school[classroom_needing_a_new_teacher].erase(sick_teacher);
-			_the_cohorts[0].erase(sick_teacher);
+			unseat(classroom_needing_a_new_teacher, sick_teacher);
+			_the_cohorts.erase(0, sick_teacher);
 
 			// hire and onboard the substitute
-			_school[classroom_needing_a_new_teacher].insert(substitute_teacher); // put them in the classroom
-			_the_cohorts[0].insert(substitute_teacher); // they'll report to school every day, so put them on cohort 0
+			assign_classroom(substitute_teacher, classroom_needing_a_new_teacher);
+			add_to_roster(classroom_needing_a_new_teacher, substitute_teacher);
+			seat(classroom_needing_a_new_teacher, substitute_teacher); // put them in the classroom
+			_the_cohorts.insert(0, substitute_teacher); // they'll report to school every day, so put them on cohort 0
 
 			// set their individual characteristics
-			_Population[substitute_teacher].set_classroom(classroom_needing_a_new_teacher);
-			_Population[substitute_teacher].set_cohort(0);
+			_agents._cohort[substitute_teacher] = 0;
+			update_school_attendance(substitute_teacher);
 
 			return;
 		}
 
+		/*
+			make the given household held in reserve into a real one (the next one not made yet, if none is given), and return
+				the ID of the first person in it - the rest follow in the order they were drawn
+		*/
+		int make_substitute_household(int reserve_household = -1)
+		{
+			assert(_substitute_households_in_reserve > 0);
+			if(reserve_household == -1)
+			{
+				reserve_household = 0;
+				while(_reserve_made[reserve_household]){ ++reserve_household; }
+			}
+			assert(not _reserve_made[reserve_household]);
+			_reserve_made[reserve_household] = true;
+			-- _substitute_households_in_reserve;
+
+			const Household_Table& houses = the_households();
+			const int household_number = houses.numbers()[houses.num_households()-1] + 1;
+			const int first_new_agent = _agents.size();
+			for(int person = _reserve_offsets[reserve_household]; person < _reserve_offsets[reserve_household+1]; ++person)
+			{
+				const char the_age = _reserve_ages[person];
+				const char the_status = _reserve_statuses[person];
+				add_agent(Person(the_age, household_number, 'S', -1));
+				// some of them may have had it already, same as everyone else (see R_init)
+				if(the_status == 'R'){ set_status(_agents.size()-1, 'R', Locale_Initial); }
+
+				// they're not in reserve anymore
+				-- _reserve_in_status[status_index(the_status)];
+				(the_age == 'A') ? -- _reserve_adults : -- _reserve_children;
+			}
+			the_households(); // take the new house into the substitute pool
+			return first_new_agent;
+		}
+
 		/*
 			Say one of the teachers originally assigned to the school recovered from their illness and is now eligible for
 				return to class. This function brings them back and tosses the sub out.
@@ -314,35 +1098,37 @@ class Town
 		void rehire_recovered_OG_teacher(const int recovered_teacher)
 		{
 			// should be adult, have a classroom number and be out of isolation
-			assert(_Population[recovered_teacher].classroom() != -1);
-			assert(_Population[recovered_teacher].age() == 'A');
+			assert(_agents._classroom[recovered_teacher] != -1);
+			assert(_agents._age[recovered_teacher] == 'A');
 			assert(not is_in_isolation(recovered_teacher));
-			// assert(_Population[recovered_teacher].status() == 'R');
+			// assert(_agents._disease_status[recovered_teacher] == 'R');
 
 			// sanity check - if the teacher isn't one of the original ones, don';t try to *re*hire them - that makes no sense
-			if(not extract_keys(_substitute_list_OGs_first).count(recovered_teacher)){ return; };
+			if(not _substitute_list_OGs_first.count(recovered_teacher)){ return; };
 			// sanity check - the one we're trying to *re*hire isn't a substitute
-			assert(not set_of_values(_substitute_list_OGs_first).count(recovered_teacher));
-			assert(_substitute_list_OGs_first.count(recovered_teacher));
-			// assert(_Population[recovered_teacher].days_since_first_symptoms() >= 14);
+			assert(not is_substitute(recovered_teacher));
+			// assert(_agents._days_since_first_symptoms[recovered_teacher] >= 14);
 
 			// find the teacher currently subbing for them
 			const int teacher_substituting_for_them = _substitute_list_OGs_first[recovered_teacher];
-			const int classroom_number = _Population[recovered_teacher].classroom();
+			const int classroom_number = _agents._classroom[recovered_teacher];
 
 			// the classroom numbers of the recovered teacher and the temp should be the same
-			assert(classroom_number == _Population[teacher_substituting_for_them].classroom());
+			assert(classroom_number == _agents._classroom[teacher_substituting_for_them]);
 
 			// sack the sub, and change their individual characteristics
-			_school[classroom_number].erase(teacher_substituting_for_them);
-			_Population[teacher_substituting_for_them].set_classroom(-1);
-			_Population[teacher_substituting_for_them].set_cohort(-1);
-			_the_cohorts[0].erase(teacher_substituting_for_them);
+			unseat(classroom_number, teacher_substituting_for_them);
+			assign_classroom(teacher_substituting_for_them, -1);
+			_agents._cohort[teacher_substituting_for_them] = -1;
+			_the_cohorts.erase(0, teacher_substituting_for_them);
+			remove_from_roster(classroom_number, teacher_substituting_for_them);
+			update_school_attendance(teacher_substituting_for_them);
 
 			// rehire the recovered teacher
-			_school[classroom_number].insert(recovered_teacher);
+			seat(classroom_number, recovered_teacher);
 			_substitute_list_OGs_first.erase(recovered_teacher);
-			_the_cohorts[0].insert(recovered_teacher);
+			_OG_teacher_of[teacher_substituting_for_them] = -1;
+			_the_cohorts.insert(0, recovered_teacher);
 		}
 
 	public:
@@ -354,23 +1140,30 @@ class Town
 		*/
 
 		// iterating over the network in a loop is more convenient
-		std::vector<int>::iterator begin() noexcept { return _agent_IDs.begin(); }
-		std::vector<int>::iterator end() { return _agent_IDs.end(); }
+		Town_Vector<int>::iterator begin() noexcept { return _agent_IDs.begin(); }
+		Town_Vector<int>::iterator end() { return _agent_IDs.end(); }
+
+		/*
+			Child-Adult contact matrices built using the Canada-specific household and school contact matrices given be Prem et. al. (2017)
+			Index: [age of the first agent][age of the second] (this order matters, so don't change this), 0 for a child and 1 for an adult
+		*/
+		static constexpr float School_Contact_Matrix[2][2] = { {1.2355, 0.0589}, {0.1176, 0.0451} };
+		static constexpr float Home_Contact_Matrix[2][2] = { {0.5378, 0.3916}, {0.3632, 0.3335} };
 
 		// Canada-specific school contact matrix for individual interactions
-		const float school_contact_rate(const char state_A, const char state_B /* this order matters, so don't change this */)
+		const float school_contact_rate(const char state_A, const char state_B /* this order matters, so don't change this */) const
 		{
 			assert(std::set<char>({'A','C'}).count(state_A));
 			assert(std::set<char>({'A','C'}).count(state_B));
-			return _school_contact_matrix[{state_A, state_B}];
+			return School_Contact_Matrix[state_A == 'A'][state_B == 'A'];
 		}
 
 		// Canada-specific household contact matrix for individual interactions
-		const float home_contact_rate(const char state_A, const char state_B /* this order matter, so don't change this */)
+		const float home_contact_rate(const char state_A, const char state_B /* this order matter, so don't change this */) const
 		{
 			assert(std::set<char>({'A','C'}).count(state_A));
 			assert(std::set<char>({'A','C'}).count(state_B));
-			return _home_contact_matrix[{state_A, state_B}];
+			return Home_Contact_Matrix[state_A == 'A'][state_B == 'A'];
 		}
 
 		// number of children and adults in a household, using 2018 StatCan census data
@@ -406,329 +1199,597 @@ class Town
 												  { return 7; }
 		}
 
+		/*
+			Put every piece of state back the way it was when the Town was built, but keep the storage everything has grown so
+				far: each container is emptied rather than replaced, so it holds on to its capacity (and its place in the arena).
+				This way one Town can be used for instance after instance without allocating everything all over again.
+		*/
 		void reset()
 		{{ // double brace for code folding
-			_Population = {};
-			_agent_IDs = {};
-			_households = {};
-			_school = {};
-			_disease_compartments = {};
+			_agents.clear();
+			_agent_IDs.clear();
+			_external_IDs.clear();
+			_households.clear();
+			_households_out_of_date = false;
+			_school.clear();
+			_closure_ledger.clear();
+			_current_closure.clear();
+			_num_closed_classrooms = 0;
+			_child_closure_days_so_far = 0;
+			for(Town_Vector<int>& the_day : _reopenings_due){ the_day.clear(); }
+			_reopenings_due.resize(Closure_Wheel_Size);
+			_substitute_list_OGs_first.clear();
+			_OG_teacher_of.clear();
+			_substitute_pool.clear();
+			_num_assigned_to_school.clear();
+			_assigned_a_classroom.reset();
+			_available_substitutes.reset();
+			_reserve_ages.clear();
+			_reserve_statuses.clear();
+			_reserve_offsets.clear();
+			_reserve_made.clear();
+			_substitute_households_in_reserve = 0;
+			_reserve_in_status.fill(0);
+			_reserve_adults = 0;
+			_reserve_children = 0;
+			for(Agent_Bitset& the_compartment : _disease_compartments){ the_compartment.reset(); }
+			_compartment_in_use.fill(false);
+			_run_time = 0;
+			_the_cohorts.clear();
+			for(Agent_Bitset& the_place : _places_infected){ the_place.reset(); }
+			_class_rosters.clear();
+			_classroom_slots.clear();
+			_roster_slot.clear();
+			_school_attendees.reset();
+			_num_in_school.fill(0);
+			_children_kept_home.reset();
+			_isolation_in_progress.reset();
+			_exposure_pending.reset();
+			_has_a_classroom.reset();
+			_spreading_at_home.reset();
+			_home_pressure.clear();
+			_households_under_pressure.reset();
+			_classes_to_reopen.clear();
+			_reopening_roster.clear();
+			_pending_exposures.clear();
+			_pending_status_changes.clear();
+			_recording_arrivals = false;
+			_arrivals.clear();
+			_transition_day.clear();
+			for(Town_Vector<int>& the_day : _transitions_due){ the_day.clear(); }
+			_num_adults = 0;
+			_num_children = 0;
 		}}
 
 		/* GETTERS */
 
 		// in the case of alternating cohorts, see which one is in class this week
-		const int this_weeks_cohort()
+		// (only cohorts 1 and 2 alternate, so there's no need to copy out all the keys to count them)
+		const int this_weeks_cohort() const
 		{
-			std::set<int> all_the_cohorts = extract_keys(_the_cohorts);
-			all_the_cohorts.erase(0);
-			all_the_cohorts.erase(-1);
-			if(all_the_cohorts.empty()){ return 0; }
-			return (_run_time/7)%all_the_cohorts.size()+1;
+			const int num_alternating_cohorts = _the_cohorts.exists(1) + _the_cohorts.exists(2);
+			if(num_alternating_cohorts == 0){ return 0; }
+			return (_run_time/7)%num_alternating_cohorts+1;
 		}
 
 		// get the day of the week 0-6, where 0 is Monday
-		const int day_of_the_week()
+		const int day_of_the_week() const
 		{
 			return _run_time%7;
 		}
 
 		// get the time stamp of the simulation
-		const int days_elapsed()
+		const int days_elapsed() const
 		{
 			return _run_time;
 		}
 
 		// check whether it's currently the weekend (Sat. or Sun., days 5 or 6)
-		const bool currently_the_weekend()
+		const bool currently_the_weekend() const
 		{
-			return std::set<int>({5,6}).count(day_of_the_week());
+			return day_of_the_week() >= 5;
 		}
 
 		// function tells whether the agent is isolating or not, i.e. symptomatic, with less than 14 days since the onset of symptoms
-		const bool is_in_isolation(const int agent)
+		const bool is_in_isolation(const int agent) const
 		{
 			// shorter handle for the agent we want
-			Person* them = &_Population[agent];
+			const int days_since_first_symptoms = _agents._days_since_first_symptoms[agent];
 
 			// the isolation starts the day *after* the first symptoms, so day 1 and forward
-			if(them->days_since_first_symptoms() < 1) return false;
+			if(days_since_first_symptoms < 1) return false;
 			// it they're past the isolation time then they can venture out into the world again
-			if(them->days_since_first_symptoms() >= 14) return false;
+			if(days_since_first_symptoms >= 14) return false;
 			return true;
 
 		}
 
-		// size of the network
-		const int num_agents() const { return _Population.size(); }
+		// whether the agent has been hired to stand in for one of the original teachers
+		const bool is_substitute(const int agent) const
+		{
+			return _OG_teacher_of[agent] != -1;
+		}
+
+		// size of the network, counting the people in the substitute households held in reserve
+		const int num_agents() const { return _agents.size() + _reserve_adults + _reserve_children; }
+
+		// the agent who exposed them (-1 if nobody in particular did, or they haven't been exposed), and the number they've exposed
+		const int infected_by(const int agent) const { return _agents._infected_by[agent]; }
+		const int num_infected_by(const int agent) const { return _agents._num_infected[agent]; }
 
 		// returns the number of agents with the categorical age specified
 		const int num_age(const char the_age) const
 		{
 			assert((the_age == 'A') or (the_age == 'C'));
-			int count = 0;
-			for(Person agent : _Population){ count += (agent.age() == the_age); }
-			return count;
+			return (the_age == 'A') ? (_num_adults + _reserve_adults) : (_num_children + _reserve_children);
 		}
 
-		// returns the number of days (not counting weekends) for which the specified classroom has remained shut down due to infection
-		const int classroom_closure_time(const int classr)
+		/*
+			returns the number of days for which the specified classroom has remained shut down due to infection, counting the
+				day it was shut, up to the 14 days it's shut for (a weekend waiting for it to reopen isn't counted)
+		*/
+		const int classroom_closure_time(const int classr) const
 		{
 			assert( check_classroom_status(classr) );
-			if(not _classroom_num_days_shut_down_due_to_illness.count(classr)){ return 0; }
-			return _classroom_num_days_shut_down_due_to_illness[classr];
+			if(not classroom_closed_due_to_infection(classr)){ return 0; }
+			return std::min(_run_time - _closure_ledger[_current_closure[classr]].closed_on + 1, 14);
 		}
 
 		// TRUE/FALSE whether the specified classroom is closed due to infection
-		const bool classroom_closed_due_to_infection(const int classr)
+		const bool classroom_closed_due_to_infection(const int classr) const
 		{
 			assert( check_classroom_status(classr) );
-			return _classroom_num_days_shut_down_due_to_illness.count(classr);
+			return (classr >= 0) and (classr < (int)_current_closure.size()) and (_current_closure[classr] != -1);
 		}
 
 		// TRUE/FALSE whether every class in the school is shut for infection
-		const bool school_closed_due_to_infection()
+		const bool school_closed_due_to_infection() const
 		{
-			for(const int classr : extract_keys(_school))
+			for(const int classr : _school.numbers())
 			{
 				assert( check_classroom_status(classr) );
-				if(not _classroom_num_days_shut_down_due_to_illness.count(classr)){ return false; }
-				if(_classroom_num_days_shut_down_due_to_illness[classr] == 0){ return false; }
+				if(classroom_closure_time(classr) == 0){ return false; }
 			}
 			return true;
 		}
 
 		// returns the numbers of the classrooms that are closed
-		const std::set<int> closed_classrooms()
+		const std::set<int> closed_classrooms() const
+		{
+			std::set<int> retval;
+			for(int classr = 0; classr < (int)_current_closure.size(); ++classr){ if(_current_closure[classr] != -1){ retval.insert(classr); } }
+			return retval;
+		}
+
+		// how many classrooms are closed, without copying out their numbers
+		const int num_closed_classrooms() const
 		{
-			return extract_keys(_classroom_num_days_shut_down_due_to_illness);
+			return _num_closed_classrooms;
 		}
 
-		// returns the number of missed student-days in this tine step due to classroom closures
-		const int child_closure_days()
+		// every classroom closure so far, in the order they happened, with the student-days missed during each one
+		const Town_Vector<Classroom_Closure>& closure_ledger() const
+		{
+			return _closure_ledger;
+		}
+
+		/*
+			returns the number of missed student-days in this tine step due to classroom closures
+			that's children assigned a classroom, not isolating due to illness, in this week's cohort, with their classroom closed;
+				they're counted as things change (see update_school_attendance) rather than by going through everyone
+		*/
+		const int child_closure_days() const
 		{
 			// if it's the weekend, children wouldn't have been in school anyway
 			if(currently_the_weekend()) return 0;
-			// counter for the number of days
-			int child_wasted_days_count = 0;
-			// checking every agent
-			for(Person child : _Population)
-			{
-				// must be a child
-				if(child.age() != 'C'){ continue; }
-				// must be assigned a classroom
-				if(child.classroom() == -1){ continue; }
-				// not isolating **due to illness** - eligible for return to class
-				if(/*coronacated*/ is_in_isolation(child.ID()) and /*actually sick*/ std::set<char>({'I','R'}).count(child.status()) ){ continue; }
-				// their classroom should be closed
-				if(not classroom_closed_due_to_infection(child.classroom())){ continue; }
-				// it also doesn't count as a wasted day if their cohort isn't the one in class this week anyway
-				if(child.cohort() != this_weeks_cohort()){ continue; }
-
-				++ child_wasted_days_count;
-			}
-			return child_wasted_days_count;
+			return _children_kept_home.size();
 		}
 
 		// takes an ID number and returns a Person object - handy for getting the individual characteristics in the main sim file
-		Person Agent(const int index)
+		// the Person is a view onto the agent store, so this doesn't copy any of the agent's characteristics
+		const Person Agent(const int index) const
 		{
-			return _Population[index];
+			return Person(&_agents, index);
 		}
-		// the total number of households in the model
+		// the number the agent was given when they were added to the Town (their ID, unless the agents have been renumbered)
+		const int external_ID(const int agent) const
+		{
+			assert(check_agent_number(agent));
+			return _external_IDs[agent];
+		}
+
+		// the total number of households in the model (including the ones held in reserve)
 		const int num_households()
 		{
-			return _households.size();
+			return the_households().num_households() + _substitute_households_in_reserve;
 		}
 
 		// the number of agents in a given household
 		const int household_size(const int index)
 		{
-			assert(_households.count(index));
-			return _households[index].size();
+			assert(the_households().contains(index));
+			return the_households().size(index);
 		}
 
-		// returns the IDs of the agents in a given household
-		const std::vector<int> household(const int index)
+		// returns the IDs of the agents in a given household - a range over the household table, so nothing is copied
+		const Agent_Range household(const int index)
 		{
-			assert(_households.count(index));
-			return std::vector<int>(_households[index].begin(), _households[index].end());
+			assert(the_households().contains(index));
+			return the_households().members(index);
 		}
 
-		// return all households. Key - house number. Value - set of all the agents in that house
-		const std::map<int, std::set<int>> households(){ return _households; }
+		// the numbers of the households with anyone in them who can pass the infection on at home (infectious and not isolating), in order
+		const Agent_Bitset& households_under_pressure() const { return _households_under_pressure; }
 
-		const std::vector<int> adults_in_household(const int index)
+		// the number of children ('C') or adults ('A') living in the household who can pass the infection on at home
+		const int home_pressure(const int house, const char the_age) const
 		{
-			assert(_households.count(index));
-			std::vector<int> the_adults;
+			assert((the_age == 'A') or (the_age == 'C'));
+			if((house < 0) or (house >= (int)_home_pressure.size())){ return 0; }
+			return _home_pressure[house][the_age == 'A'];
+		}
+
+		// whether the agent is counted in the pressure of their household (infectious, and not isolating)
+		const bool is_spreading_at_home(const int agent) const { return _spreading_at_home.contains(agent); }
+
+		// view of all the households, in order. First - house number. Second - range of all the agents in that house
+		const Household_List_View households()
+		{
+			return Household_List_View(&the_households());
+		}
+
+		const Town_Vector<int> adults_in_household(const int index)
+		{
+			assert(the_households().contains(index));
+			Town_Vector<int> the_adults(&_arena);
 			std::copy_if(
-				_households[index].begin(),
-				_households[index].end(),
+				household(index).begin(),
+				household(index).end(),
 				std::back_inserter(the_adults),
-				[=](int person){ return (_Population[person].age()=='A'); }
+				[=](int person){ return (_agents._age[person]=='A'); }
 			);
 			return the_adults;
 		}
 
 		// return the IDs of all the children in a given house
-		const std::vector<int> children_in_household(const int index)
+		const Town_Vector<int> children_in_household(const int index)
 		{
-			assert(_households.count(index));
-			std::vector<int> the_children;
+			assert(the_households().contains(index));
+			Town_Vector<int> the_children(&_arena);
 			std::copy_if(
-				_households[index].begin(),
-				_households[index].end(),
+				household(index).begin(),
+				household(index).end(),
 				std::back_inserter(the_children),
-				[=](int person){ return (_Population[person].age()=='C'); }
+				[=](int person){ return (_agents._age[person]=='C'); }
 			);
 			return the_children;
 		}
 
 		// a set of all the house numbers in the population
-		const std::set<int> home_addresses() { return extract_keys(_households); }
+		const std::set<int> home_addresses() { return std::set<int>(the_households().numbers().begin(), the_households().numbers().end()); }
 
 		// number of valid classrooms in the school
-		const int num_classrooms() const { return _school.size()-_school.count(-1); }
+		const int num_classrooms() const { return _school.size()-_school.exists(-1); }
 
 		// number of attendees actually in a class at the moment (so not counting students that are out sick)
-		const int class_size(const int class_number) { return _school[class_number].size(); }
+		const int class_size(const int class_number) const { return _school.members(class_number).size(); }
 
-		// return a set of the IDs of agents in a given class
-		const std::set<int> classroom(const int class_number) { return _school[class_number]; }
+		// the IDs of agents in a given class, sorted
+		const Agent_Range classroom(const int class_number) const { return _school.members(class_number); }
 
-		// all the classrooms in the school. Key-  class number. Value - set of IDs of agents sitting in that class at the moment
-		const std::map<int, std::set<int>> classrooms()
+		// the numbers of all the classrooms in the school, in order
+		const Agent_Range classroom_numbers() const { return _school.numbers(); }
+
+		// view of all the classrooms in the school, in order. First - class number. Second - sorted IDs of agents sitting in that class at the moment
+		const Group_List_View<Classroom_Groups> classrooms() const
 		{
-			std::map<int, std::set<int>> the_classes = _school;
-			the_classes.erase(-1);
-			return the_classes;
+			return Group_List_View<Classroom_Groups>(&_school);
+		}
+
+		// the IDs of every agent on a given classroom's roster, sorted, whether they're sitting in the class or not. their slots are their places in this list
+		const Agent_Range classroom_roster(const int class_number) const { return _class_rosters.members(class_number); }
+
+		/*
+			gives the roster slots of the agents sitting in the given class with the given disease statuses (or of everyone sitting
+				in it, if none are given). classroom_roster(class_number)[slot] is the agent's ID
+
+			it's a view over the classroom's masks (see Classroom_Slots), so there's no looking up the agents and nothing is copied
+		*/
+		template<typename Status_Collection> const Agent_Group classroom_slots(const int class_number, const Status_Collection& the_statuses) const
+		{
+			Agent_Group the_slots;
+			if((class_number < 0) or (class_number >= (int)_classroom_slots.size())){ return the_slots; }
+			const Classroom_Slots& slots = _classroom_slots[class_number];
+			if(the_statuses.size() == 0)
+			{
+				the_slots.add(&slots.present);
+				return the_slots;
+			}
+			for(const char one_state : the_statuses)
+			{
+				assert(check_disease_status(one_state));
+				the_slots.add(&slots.in_status[status_index(one_state)]);
+			}
+			the_slots.restrict_to(&slots.present);
+			return the_slots;
+		}
+		const Agent_Group classroom_slots(const int class_number) const { return classroom_slots(class_number, std::set<char>()); }
+		const Agent_Group classroom_slots(const int class_number, const std::initializer_list<char> the_statuses) const
+		{
+			return classroom_slots<std::initializer_list<char>>(class_number, the_statuses);
+		}
+
+		// number of adults ('A') or children ('C') sitting in the given class at the moment
+		const int num_in_classroom(const int class_number, const char the_age) const
+		{
+			assert((the_age == 'A') or (the_age == 'C'));
+			if((class_number < 0) or (class_number >= (int)_classroom_slots.size())){ return 0; }
+			return _classroom_slots[class_number].present_by_age[the_age == 'A'].size();
 		}
 
 		// get the IDs of teachers in the given classroom - in the model, could be either one or two
-		const std::vector<int> teachers_in_classroom(const int index)
+		const Town_Vector<int> teachers_in_classroom(const int index)
 		{
-			assert(_school.count(index));
-			std::vector<int> the_adults;
+			assert(_school.exists(index));
+			Town_Vector<int> the_adults(&_arena);
 			std::copy_if(
-				_school[index].begin(),
-				_school[index].end(),
+				_school.members(index).begin(),
+				_school.members(index).end(),
 				std::back_inserter(the_adults),
 				[=](int person)
 				{
 					assert(not is_in_isolation(person));
-					return (_Population[person].age()=='A');
+					return (_agents._age[person]=='A');
 				}
 			);
 			return the_adults;
 		}
 
 		// get the IDs of children in the given classroom
-		const std::vector<int> children_in_classroom(const int index)
+		const Town_Vector<int> children_in_classroom(const int index)
 		{
-			assert(_school.count(index));
-			std::vector<int> the_children;
+			assert(_school.exists(index));
+			Town_Vector<int> the_children(&_arena);
 			std::copy_if(
-				_school[index].begin(),
-				_school[index].end(),
+				_school.members(index).begin(),
+				_school.members(index).end(),
 				std::back_inserter(the_children),
 				[=](int person)
 				{
 					assert(not is_in_isolation(person));
-					return (_Population[person].age()=='C');
+					return (_agents._age[person]=='C');
 				}
 			);
 			return the_children;
 		}
 
-		// return a set of all the IDs of agents in the given single stage of the SEPAIR disease progression
-		const std::set<int> agents(const char the_status = '\0')
+		// the bitset of the agents in the given single stage of the SEPAIR disease progression. copy it for a snapshot
+		const Agent_Bitset& compartment(const char the_status) const
 		{
-			if(the_status == '\0'){ return std::set<int>(_agent_IDs.begin(), _agent_IDs.end()); }
 			assert(check_disease_status(the_status));
-			return _disease_compartments[the_status];
+			return _disease_compartments[status_index(the_status)];
 		}
 
 		/*
-			returns a collection of all the agent IDs in multiple states in the disease progression
-			Ex. agents({'S','E'}) will return a collection of susceptible and exposed agents
+			return all the IDs of agents in the given single stage of the SEPAIR disease progression (or everyone, if no status is given)
+			the result is a view over the compartments, sorted by ID; it doesn't copy anything
 		*/
-		const std::set<int> agents(std::set<char> the_statuses)
+		const Agent_Group agents(const char the_status = '\0') const
 		{
-			std::set<int> the_collection {};
-			for(char one_state : the_statuses)
+			Agent_Group the_collection;
+			if(the_status == '\0')
 			{
-				if(not _disease_compartments.count(one_state)){ continue; }
-				std::set<int> temp = _disease_compartments[one_state];
-				std::copy(temp.begin(), temp.end(), std::inserter(the_collection, the_collection.begin()));
+				for(const Agent_Bitset& the_compartment : _disease_compartments){ the_collection.add(&the_compartment); }
+				return the_collection;
 			}
+			assert(check_disease_status(the_status));
+			the_collection.add(&_disease_compartments[status_index(the_status)]);
+			return the_collection;
+		}
+
+		/*
+			returns a collection of all the agent IDs in multiple states in the disease progression
+			Ex. agents({'S','E'}) will return a collection of susceptible and exposed agents
+		*/
+		const Agent_Group agents(const std::initializer_list<char> the_statuses) const
+		{
+			Agent_Group the_collection;
+			for(char one_state : the_statuses){ the_collection.add(&_disease_compartments[status_index(one_state)]); }
+			return the_collection;
+		}
+		const Agent_Group agents(const std::set<char>& the_statuses) const
+		{
+			Agent_Group the_collection;
+			for(char one_state : the_statuses){ the_collection.add(&_disease_compartments[status_index(one_state)]); }
+			return the_collection;
+		}
+
+		// the agents with the given disease status who are assigned to a classroom (teachers and students), or who aren't
+		const Agent_Group agents_with_classroom(const char the_status) const
+		{
+			Agent_Group the_collection = agents(the_status);
+			the_collection.restrict_to(&_has_a_classroom);
+			return the_collection;
+		}
+		const Agent_Group agents_without_classroom(const char the_status) const
+		{
+			Agent_Group the_collection = agents(the_status);
+			the_collection.exclude(&_has_a_classroom);
 			return the_collection;
 		}
 
-		// returns the proportion of agents with the given disease status
-		const float agents_proportion(const char the_status)
+		// returns the proportion of agents with the given disease status (the households held in reserve count too)
+		const float agents_proportion(const char the_status) const
 		{
-			if(_disease_compartments.count(the_status))
+			const int num_in_reserve = _reserve_in_status[status_index(the_status)];
+			if(_compartment_in_use[status_index(the_status)] or (num_in_reserve != 0))
 			{
-				return _disease_compartments[the_status].size()/(1.*_Population.size());
+				return (_disease_compartments[status_index(the_status)].size() + num_in_reserve)/(1.*num_agents());
 			}
 			return 0;
 		}
 
 		/*
-			gives a set of IDs of the agents currently in school (that is, not sick teachers or children home from school,
+			gives the IDs of the agents currently in school (that is, not sick teachers or children home from school,
 				or children in the cohort not meeting this week) with the given disease statuses
+
+			this is anyone with non-trivial classroom number in an open classroom and isolation counter either 0 or above 14
+			this is sufficient to catch the children out of school, the subs serving at the school while filtering out the OG teachers recovering at home
+			we want an asses-in-the-seats count
+
+			the attendees are tracked as things change (see _school_attendees), so the result is just a view over the disease
+				compartments restricted to the attendees; nothing gets copied
 		*/
-		const std::set<int> agents_in_school(const std::set<char> the_statuses = {})
+		const Agent_Group agents_in_school() const { return attendees_in_states(std::set<char>()); }
+		const Agent_Group agents_in_school(const std::initializer_list<char> the_statuses) const { return attendees_in_states(the_statuses); }
+		const Agent_Group agents_in_school(const std::set<char>& the_statuses) const { return attendees_in_states(the_statuses); }
+
+		// number of agents currently in school with the given disease status
+		const int num_in_school(const char the_status) const
 		{
+			assert(check_disease_status(the_status));
 			// no one's in school on the weekend
-			if(currently_the_weekend()) return {};
-			for(char state : the_statuses){ assert(check_disease_status(state)); }
-
-			// get the disease statuses we want the attendees to have
-			std::set<char> all_them {};
-			if(the_statuses.empty()){ all_them = _disease_statuses; }
-			else{ all_them = the_statuses; }
-
-			// get all the people in the school - this is anyone with non-trivial classroom number in an open classroom and isolation counter either 0 or above 14
-			// this is sufficient to catch the children out of school, the subs serving at the school while filtering out the OG teachers recovering at home
-			// we want an asses-in-the-seats count
-			std::set<int> school_attendees_in_state {};
-			for(char one_state : all_them)
-			{
-				std::copy_if(
-					_agent_IDs.begin(),
-					_agent_IDs.end(),
-					std::inserter(school_attendees_in_state, school_attendees_in_state.begin()),
-					[=](int agent){
-						if(_Population[agent].status() != one_state){ return false; } // in the correct disease state
-						if(classroom_closed_due_to_infection(_Population[agent].classroom())){ return false; } // classroom open
-						if(_Population[agent].classroom() == -1 ){ return false; } // assigned to a room in the centre
-						if(is_in_isolation(agent)){ return false; } // must be healthy and fit to be in class
-						if(not std::set<int>({this_weeks_cohort(), 0}).count(_Population[agent].cohort()) ){ return false; } // in this week's cohort
-						return true;
-					}
-				);
-			}
-			return school_attendees_in_state;
+			if(currently_the_weekend()){ return 0; }
+			return _num_in_school[status_index(the_status)];
 		}
 
 		// proportion of agents currently in school with the given disease status
-		const float agents_in_school_proportion(const char the_status)
+		const float agents_in_school_proportion(const char the_status) const
 		{
-			return agents_in_school({the_status}).size()/(1.*agents_in_school().size());
+			const int num_attendees = currently_the_weekend() ? 0 : _school_attendees.size();
+			return num_in_school(the_status)/(1.*num_attendees);
+		}
+
+		// number of agents carrying the disease at the moment (exposed, presymptomatic, symptomatic or asymptomatic)
+		const int num_active_infections() const
+		{
+			int count = 0;
+			for(int state = 0; state < Num_Disease_Statuses; ++state){ if(Disease.infected[state]){ count += _disease_compartments[state].size(); } }
+			return count;
 		}
 
 		// number of infections occurring in the requested location
-		const int locale_infections(const std::string place)
+		const int locale_infections(const Infection_Locale place) const
 		{
-			if(place == ""){ return -1; };
-			if(not _places_infected.count(place)){ return 0; }
+			if(place == Locale_None){ return -1; };
 			return _places_infected[place].size();
 		}
+		const int locale_infections(const std::string place) const
+		{
+			if(place == ""){ return -1; };
+			if(infection_locale_from_name(place) == Locale_None){ return 0; }
+			return locale_infections(infection_locale_from_name(place));
+		}
 
 		/* SETTERS */
 
+		/*
+			Add a household of the sort teachers come from (and substitutes): 36% of them are just adults, and the rest have
+				children too, with their sizes drawn from the census distributions. Nobody in it is assigned to the school yet.
+		*/
+		void add_teacher_household(const int household_number, std::mt19937& generator)
+		{
+			const std::pair<int, int> Children_First_Adults_Second = draw_teacher_household(generator);
+			// throw the children in there
+			for(int num_children=0; num_children < Children_First_Adults_Second.first; ++num_children)
+			{
+				add_agent(Person('C', household_number, 'S', -1));
+			}
+			// aaaand the adults...
+			for(int num_adults=0; num_adults < Children_First_Adults_Second.second; ++num_adults)
+			{
+				add_agent(Person('A', household_number, 'S', -1));
+			}
+		}
+
+		// how many children and adults there are in a teacher household (see add_teacher_household)
+		std::pair<int, int> draw_teacher_household(std::mt19937& generator)
+		{
+			std::uniform_real_distribution<float> randfloat(0,1);
+
+			// if it's a house with just adults, get the house size from the distribution
+			if(randfloat(generator) < Percentage_Teachers_With_No_Children)
+			{
+				return {0, just_adults_household_size_distribution(randfloat(generator))};
+			}
+			// there are children in the house too
+			return children_and_adults_household_size_distribution(randfloat(generator));
+		}
+
+		/*
+			Hold the given number of substitute households in reserve, to be made only when they're needed (see
+				_substitute_households_in_reserve). Who's in them is drawn now, from their own stream of the instance's seed.
+		*/
+		void keep_substitute_households_in_reserve(const int num_households, const float R_init, const int instance_seed)
+		{
+			std::seed_seq substream {instance_seed, 1}; // the instance itself uses the plain seed
+			_reserve_generator.seed(substream);
+			std::uniform_real_distribution<float> randfloat(0,1);
+
+			for(int house = 0; house < num_households; ++house)
+			{
+				_reserve_offsets.push_back(_reserve_ages.size());
+				_reserve_made.push_back(false);
+				const std::pair<int, int> Children_First_Adults_Second = draw_teacher_household(_reserve_generator);
+				for(int person = 0; person < Children_First_Adults_Second.first + Children_First_Adults_Second.second; ++person)
+				{
+					const char the_age = (person < Children_First_Adults_Second.first) ? 'C' : 'A';
+					// some of them may have had it already, same as everyone else (see R_init)
+					const char the_status = (randfloat(_reserve_generator) < R_init) ? 'R' : 'S';
+					_reserve_ages.push_back(the_age);
+					_reserve_statuses.push_back(the_status);
+					++ _reserve_in_status[status_index(the_status)];
+					(the_age == 'A') ? ++ _reserve_adults : ++ _reserve_children;
+				}
+			}
+			_reserve_offsets.push_back(_reserve_ages.size());
+			_substitute_households_in_reserve = num_households;
+		}
+
+		/*
+			The people in the households held in reserve catch it in the community like anyone else out of school, with the
+				given chance each. Since they aren't real agents yet, how many of the susceptible ones catch it today is drawn all
+				at once (binomial), then which ones (all sets of that many equally likely), and only their households are made.
+		*/
+		void expose_the_reserve(const float chance)
+		{
+			const int num_susceptible = _reserve_in_status[status_index('S')];
+			if(num_susceptible == 0){ return; }
+			const int num_caught = std::binomial_distribution<int>(num_susceptible, chance)(_reserve_generator);
+			if(num_caught == 0){ return; }
+
+			// pick which of the susceptibles, numbered in order through the households not made yet (Floyd's algorithm)
+			std::set<int> caught;
+			for(int top = num_susceptible-num_caught; top < num_susceptible; ++top)
+			{
+				const int pick = std::uniform_int_distribution<int>(0, top)(_reserve_generator);
+				caught.insert(caught.count(pick) ? top : pick);
+			}
+
+			// make the households they're in, and expose them
+			std::set<int>::const_iterator next_caught = caught.begin();
+			int susceptible_number = 0;
+			for(int house = 0; (house < (int)_reserve_made.size()) and (next_caught != caught.end()); ++house)
+			{
+				if(_reserve_made[house]){ continue; }
+				std::vector<int> caught_here; // by where they are in the household
+				for(int person = _reserve_offsets[house]; person < _reserve_offsets[house+1]; ++person)
+				{
+					if(_reserve_statuses[person] != 'S'){ continue; }
+					if((next_caught != caught.end()) and (*next_caught == susceptible_number))
+					{
+						caught_here.push_back(person - _reserve_offsets[house]);
+						++next_caught;
+					}
+					++susceptible_number;
+				}
+				if(caught_here.empty()){ continue; }
+
+				const int first_new_agent = make_substitute_household(house);
+				for(const int person : caught_here){ expose(first_new_agent + person, Locale_Background); }
+			}
+		}
+
 		/*
 			add an agent to the simulation, including setting classroom and cohort, etc.
 		*/
@@ -737,26 +1798,47 @@ class Town
 			assert(check_disease_status(them.status()));
 
 			// the new agent will be pushed to the back of the vector of agents, and will get the next biggest number integer available
-			int temp_identity = _Population.size();
-			_Population.push_back(them); // add the object to the vector of objects
+			int temp_identity = _agents.size();
 			_agent_IDs.push_back(temp_identity); // add their ID to the list of IDs
+			_external_IDs.push_back(temp_identity);
+			_OG_teacher_of.push_back(-1);
+			_roster_slot.push_back(-1);
+			_transition_day.push_back(-1);
 
 			// we know what the number will be, since we're always pushing at the back
-			_households[ them.household() ].insert(temp_identity); // put them in the requested household
-			_disease_compartments[them.status()].insert(temp_identity); // add them to the specified disease compartment
+			_households_out_of_date = true; // they'll be put in the requested household when the table is next built
+			for(Agent_Bitset& the_compartment : _disease_compartments){ the_compartment.resize(temp_identity+1); }
+			_disease_compartments[status_index(them.status())].insert(temp_identity); // add them to the specified disease compartment
+			_compartment_in_use[status_index(them.status())] = true;
 
 			// if we add an exposed agent, we don't care where they were infected - that's a them problem
 			// so we're not setting an infection locale for the node here
 
-			//sorting out individual characteristics of the agent
-			_Population.back().set_identity(temp_identity); //ID
-			_Population.back().set_household(them.household()); // household
-			_Population.back().set_age(them.age()); // age
-			_Population.back().set_status(them.status()); // stage of disease progression
-			// _Population.back().set_classroom(them.classroom()); // classroom they're in
-			_Population.back().set_days_since_first_symptoms(them.days_since_first_symptoms()); // time since the first cough
+			//sorting out individual characteristics of the agent - the ID is their position in the store
+			_agents._household.push_back(them.household()); // household
+			_agents._age.push_back(them.age()); // age
+			_agents._disease_status.push_back(them.status()); // stage of disease progression
+			_agents._time_step_infected_at.push_back(0);
+			_agents._infected_by.push_back(-1);
+			_agents._num_infected.push_back(0);
+			_agents._classroom.push_back(them.classroom()); // classroom they're in
+			_agents._cohort.push_back(them.cohort());
+			_agents._days_since_first_symptoms.push_back(them.days_since_first_symptoms()); // time since the first cough
+			_agents._infection_locale.push_back(them.infection_locale());
+			_school_attendees.resize(temp_identity+1);
+			_children_kept_home.resize(temp_identity+1);
+			_isolation_in_progress.resize(temp_identity+1);
+			_exposure_pending.resize(temp_identity+1);
+			_has_a_classroom.resize(temp_identity+1);
+			_spreading_at_home.resize(temp_identity+1);
+			_assigned_a_classroom.resize(temp_identity+1);
+			_available_substitutes.resize(temp_identity+1);
+			for(Agent_Bitset& the_place : _places_infected){ the_place.resize(temp_identity+1); }
+			_num_adults += (them.age() == 'A');
+			_num_children += (them.age() == 'C');
 
 			set_classroom(temp_identity, them.classroom(), them.cohort()); // insert the node into the requested classroom and cohort
+			recheck_home_pressure(temp_identity);
 		}
 
 		/*
@@ -770,43 +1852,60 @@ class Town
 				There's nothing more permanent than a temporary solution that works.
 			*/
 
+			// close the books on the day that's just finished
+			_child_closure_days_so_far += child_closure_days();
+			if(_num_closed_classrooms != 0){ record_missed_student_days(); }
+
 			_run_time += 1;
 
+			// new week, so the other cohort (if there is one) is due in class
+			if(day_of_the_week() == 0){ update_all_school_attendance(); }
+
 			// if it's Friday, all the classes get out - regardless of disease or not - this clears space for the new cohort
 			if(day_of_the_week() == 5)
 			{
-				for(int classr : extract_keys(_school)){ _school[classr].clear(); }
+				for(const int classr : _school.numbers()){ empty_classroom(classr); recheck_isolation_in_progress(classr); }
 			}
 
-			// if anyone is symptomatic for the second day and they're in a class that hasn't been shut, then shut down the class
-			for(const int person : agents({'I', 'R'}))
+			/*
+				if anyone is symptomatic for the second day and they're in a class that hasn't been shut, then shut down the class
+				(only the I and R agents with something left to do - see _isolation_in_progress. the rest would be skipped anyway)
+			*/
+			for(const int person : _isolation_in_progress)
 			{
 				assert(check_agent_number(person));
 
-				Person* them = &_Population[person];
+				const Person them = Agent(person);
 
 				// if they're symptomatic but not recovered yet, mark one more day passed
-				if((them->days_since_first_symptoms() > -1) and (them->days_since_first_symptoms() < 14))
+				if((them.days_since_first_symptoms() > -1) and (them.days_since_first_symptoms() < 14))
 				{
-					them->add_day_since_first_symptoms();
+					++ _agents._days_since_first_symptoms[person];
+					update_school_attendance(person);
+					recheck_home_pressure(person);
 				}
 				// checking to see which classrooms to shut down
-				if( (them->classroom() != -1) and (not classroom_closed_due_to_infection(them->classroom())) )
+				if( (them.classroom() != -1) and (not classroom_closed_due_to_infection(them.classroom())) )
 				{
 					// sick and currently running amok in the classroom
-					if( (them->days_since_first_symptoms() - them->weekend_offset()) == 1)
+					if( (them.days_since_first_symptoms() - them.weekend_offset()) == 1)
 					{
 						// shut the classroom down
-						_classroom_num_days_shut_down_due_to_illness[them->classroom()] = 0;
+						close_classroom(them.classroom());
+						update_classroom_attendance(them.classroom());
 						// no one in the classroom anymore
-						_school[them->classroom()].clear();
+						empty_classroom(them.classroom());
+						recheck_isolation_in_progress(them.classroom());
 
 						//////////////// THIS CAN BE REMOVED IF WE WANT TO ASSUME THAT CHILDREN CAN'T ISOLATE EFFECTIVELY AT HOME ////////////////
 
 						// everyone dismissed from that class isolates (we hope) in our "conservative scenario"
-						for(int needs_to_isolate : _school[them->classroom()])
+						for(int needs_to_isolate : _school.members(them.classroom()))
 						{
-							_Population[needs_to_isolate].set_days_since_first_symptoms(0);
+							_agents._days_since_first_symptoms[needs_to_isolate] = 0;
+							update_school_attendance(needs_to_isolate);
+							recheck_home_pressure(needs_to_isolate);
+							if(isolation_in_progress(needs_to_isolate)){ _isolation_in_progress.insert(needs_to_isolate); }
 						}
 
 						/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -814,11 +1913,11 @@ class Town
 					// recovered from their coronacation, bring them back to the classroom
 					else if( not is_in_isolation(person) )
 					{
-						if(them->age() == 'C')
+						if(them.age() == 'C')
 						{
-							_school[them->classroom()].insert(them->ID());
+							seat(them.classroom(), them.ID());
 						}
-						else if((them->age() == 'A') and (them->status() == 'R'))
+						else if((them.age() == 'A') and (them.status() == 'R'))
 						{
 							/*
 								they only need to be rehired if they've actually left the class due to actual illness,
@@ -829,178 +1928,342 @@ class Town
 						}
 					}
 				}
+
+				// back in class (or never left it) with the counter run out - nothing more to do for them until something changes
+				if(not isolation_in_progress(person)){ _isolation_in_progress.erase(person); }
 			}
 
-			std::set<int> classes_to_reopen {};
+			// the classrooms to open up today, in order (each one once)
+			_classes_to_reopen.clear();
 
 			// bit of a unique problem here
 			// on Mondays we need to reopen all the classes with the new cohorts, while during the weekday only the recovered classes
 			// this seems a bang-on solution
 			if(day_of_the_week() == 0){
-			for(const std::pair<int, std::set<int>> classr : _school)
+			for(const int classr : _school.numbers())
 			{
-				if(not _classroom_num_days_shut_down_due_to_illness.count(classr.first)) classes_to_reopen.insert(classr.first);
+				if(not classroom_closed_due_to_infection(classr)) _classes_to_reopen.push_back(classr);
 			}}
 
-			//  increment the days of class closure. if 14 days have passed, pout down that class for reopening
-			for(const std::pair<int, int> classr : _classroom_num_days_shut_down_due_to_illness)
-			{
-				assert(check_classroom_status(classr.first));
-
-				// don't count a weekend as a closure day if the 14-day counter has already run out
-				if(classr.second < 14){ ++ _classroom_num_days_shut_down_due_to_illness[classr.first]; }
-				// if the requisite 14 days have passed. reopen the classroom
-				else if(not currently_the_weekend())
-				{
-					// printf("Class %i put on the reopening list.\n", classr.first);
-					classes_to_reopen.insert(classr.first);
-				}
-				// else, mark that another day has passed
-			}
+			// the closures that have run out today (they were put in today's slot on the wheel when the classrooms were shut)
+			Town_Vector<int>& reopening_today = _reopenings_due[_run_time%Closure_Wheel_Size];
+			_classes_to_reopen.insert(_classes_to_reopen.end(), reopening_today.begin(), reopening_today.end());
+			reopening_today.clear();
+			std::sort(_classes_to_reopen.begin(), _classes_to_reopen.end());
+			_classes_to_reopen.erase(std::unique(_classes_to_reopen.begin(), _classes_to_reopen.end()), _classes_to_reopen.end());
 
 			// persons in cohort zero return to class every week
 			// these are mostly teachers
-			std::set<int> cohorts_to_bring_back({0, this_weeks_cohort()});
+			const int cohorts_to_bring_back[2] = {0, this_weeks_cohort()};
+			const int num_cohorts_to_bring_back = (this_weeks_cohort() == 0) ? 1 : 2;
 
 			// for every classroom marked for reopening
-			for(const int classr : classes_to_reopen)
+			for(const int classr : _classes_to_reopen)
 			{
 				// take the class off the shut down list
-				_classroom_num_days_shut_down_due_to_illness.erase(classr);
+				if(classroom_closed_due_to_infection(classr)){ open_classroom(classr); }
+				update_classroom_attendance(classr);
 
 				// bring back all the eligible students
 				// for the OG teachers that are sick, hire substitutes *here* and nowhere else
-				for(const int cohort_num : cohorts_to_bring_back)
+				for(int which_cohort = 0; which_cohort < num_cohorts_to_bring_back; ++which_cohort)
 				{
-					// to avoid iterating over a changing std::set (the replace_sick_teacher_function mutates stuff)
-					std::set<int> the_group = _the_cohorts[cohort_num];
-					for(const int person : the_group)
+					const int cohort_num = cohorts_to_bring_back[which_cohort];
+
+					// only the agents assigned to this classroom can come back to it
+					// copied to avoid iterating over a changing list (the replace_sick_teacher_function mutates stuff)
+					_reopening_roster.assign(_class_rosters.members(classr).begin(), _class_rosters.members(classr).end());
+					for(const int person : _reopening_roster)
 					{
 						// spiffy handle for the object
-						Person* them = &_Population[person];
+						const Person them = Agent(person);
 
-						if(them->classroom() == classr)
+						if(_the_cohorts.contains(cohort_num, person))
 						{
 							// make sure that they're no longer infectious
-							if(not is_in_isolation(them->ID()))
+							if(not is_in_isolation(them.ID()))
 							{
-								_school[classr].insert(them->ID()); // just add them. nothing special here
+								seat(classr, them.ID()); // just add them. nothing special here
 							}
 							// sick teacher must be replaced
-							else if(them->age() == 'A')
+							else if(them.age() == 'A')
 							{
-								replace_sick_teacher(them->ID()); // hire someone else
+								replace_sick_teacher(them.ID()); // hire someone else
 							}
 						}
 					}
 				}
 			}
+
+			// the bookkeeping kept up as things change should agree with working it all out again
+			assert(check_substitute_pool());
+			assert(check_isolation_in_progress());
+			assert(check_closure_ledger());
+			assert(check_home_pressure());
 			return;
 		}
 
 		// changing the disease status of an agent and the place they got exposed
-		void set_status(const int getting_their_state_changed, const char new_status, const std::string locale="")
+		void set_status(const int getting_their_state_changed, const char new_status, const Infection_Locale locale=Locale_None)
 		{
 			assert(check_disease_status(new_status));
 			assert(check_agent_number(getting_their_state_changed));
 
 			// if someone is exposed, we need to know where. for science.
-			if( (new_status=='E') and (locale=="") )
+			if( (new_status=='E') and (locale==Locale_None) )
 			{
 				std::cerr << "PERSON EXPOSED YET LOCATION NOT GIVEN." << std::endl;
 				std::exit(EXIT_FAILURE);
 			}
 
-			Person* them = &_Population[getting_their_state_changed];
-			char old_status = them->status();
+			const Person them = Agent(getting_their_state_changed);
+			char old_status = them.status();
 
 			// if there's no change, return. else, change the status
 			if(old_status == new_status){ return; }
-			them->set_status(new_status);
+			_agents._disease_status[getting_their_state_changed] = new_status;
+			_agents._time_step_infected_at[getting_their_state_changed] = 0;
+			// whatever was scheduled for their old status is off
+			_transition_day[getting_their_state_changed] = -1;
+			if(_recording_arrivals){ _arrivals.push_back(getting_their_state_changed); }
 			// move them from the old compartment to the new one
-			_disease_compartments[old_status].erase(getting_their_state_changed);
-			_disease_compartments[new_status].insert(getting_their_state_changed);
+			_disease_compartments[status_index(old_status)].erase(getting_their_state_changed);
+			_disease_compartments[status_index(new_status)].insert(getting_their_state_changed);
+			_compartment_in_use[status_index(new_status)] = true;
+			// and the same for the count of attendees in each status
+			if(_school_attendees.contains(getting_their_state_changed))
+			{
+				-- _num_in_school[status_index(old_status)];
+				++ _num_in_school[status_index(new_status)];
+			}
+			// and in the masks of their classroom
+			if(_roster_slot[getting_their_state_changed] != -1)
+			{
+				Classroom_Slots& slots = _classroom_slots[them.classroom()];
+				slots.in_status[status_index(old_status)].erase(_roster_slot[getting_their_state_changed]);
+				slots.in_status[status_index(new_status)].insert(_roster_slot[getting_their_state_changed]);
+			}
 
-			if(new_status == 'I') // if symptomatic
+			if(Disease.symptomatic[status_index(new_status)]) // if symptomatic
 			{
 				// no way in hell you're getting back into class like that, young man!
-				them->set_days_since_first_symptoms(0, _run_time);
+				_agents._days_since_first_symptoms[getting_their_state_changed] = 0;
 			}
 			else if(new_status == 'E') // simple exposure to infection
 			{
 				// make sure that I've typed the location name correctly
 				assert(check_infection_locale(locale));
 				// sanity check - if they're not attending the school, then they can't have been infected in a school area
-				assert( (them->classroom() != -1) or ((locale !="class") and (locale != "commons")) ); //
+				assert( (them.classroom() != -1) or ((locale != Locale_Class) and (locale != Locale_Commons)) ); //
 				// mark their exposure at that place
-				_places_infected[locale].insert(them->ID());
-				them->set_infection_locale(locale);
+				_places_infected[locale].insert(them.ID());
+				_agents._infection_locale[getting_their_state_changed] = locale;
 			}
-			else if((new_status == 'R') and (locale != ""))
+			else if((new_status == 'R') and (locale != Locale_None))
 			{
 				// used in the unit tests to just speed things up instead of waiting 15 time steps. doesn't happen in the sim
-				them->set_days_since_first_symptoms(15);
+				_agents._days_since_first_symptoms[getting_their_state_changed] = 15;
 			}
+
+			// falling ill (or recovering) can change whether they're in class, or counted as missing class
+			update_school_attendance(getting_their_state_changed);
+			if(isolation_in_progress(getting_their_state_changed)){ _isolation_in_progress.insert(getting_their_state_changed); }
+			else { _isolation_in_progress.erase(getting_their_state_changed); }
+			// and whether they're spreading it at home
+			recheck_home_pressure(getting_their_state_changed);
+		}
+
+		// same as above, with the locale given by name ("home", "class", etc)
+		void set_status(const int getting_their_state_changed, const char new_status, const std::string locale)
+		{
+			assert( (locale == "") or (infection_locale_from_name(locale) != Locale_None) );
+			set_status(getting_their_state_changed, new_status, infection_locale_from_name(locale));
+		}
+
+		/*
+			Ask for the susceptible agent to be exposed at the given place (by the given agent, if it was someone in particular).
+				Nothing changes until commit_changes(); if they're exposed more than once before then, the first exposure asked
+				for is the one that counts.
+		*/
+		void expose(const int agent, const Infection_Locale locale, const int source=-1)
+		{
+			assert(check_agent_number(agent));
+			assert(check_infection_locale(locale));
+			_pending_exposures.push_back({agent, locale, source});
+			_exposure_pending.insert(agent);
+		}
+
+		/*
+			whether the agent's been asked to be exposed since the last commit_changes(). they're still S until then, but the
+				day loop doesn't try to infect them again where someone exposed earlier in the day wouldn't be tried
+		*/
+		const bool exposure_pending(const int agent) const
+		{
+			return _exposure_pending.contains(agent);
+		}
+
+		// ask for the agent to be moved on to the given disease status, when the changes are next committed
+		void change_status(const int agent, const char new_status)
+		{
+			assert(check_agent_number(agent));
+			assert(check_disease_status(new_status));
+			_pending_status_changes.push_back({agent, new_status});
+		}
+
+		/*
+			Make all the exposures and status changes asked for since the last commit, in one pass in order of agent ID: the
+				exposures first (only the first one asked for counts for each agent, and only if they're still susceptible), then
+				the status changes.
+		*/
+		void commit_changes()
+		{
+			std::stable_sort(_pending_exposures.begin(), _pending_exposures.end(),
+				[](const Pending_Exposure& first, const Pending_Exposure& second){ return first.agent < second.agent; });
+			for(const Pending_Exposure& exposure : _pending_exposures)
+			{
+				if(_agents._disease_status[exposure.agent] != 'S'){ continue; } // already exposed (just now, or before)
+				set_status(exposure.agent, 'E', exposure.locale);
+				_agents._infected_by[exposure.agent] = exposure.source;
+				if(exposure.source != -1){ ++ _agents._num_infected[exposure.source]; }
+			}
+			for(const Pending_Exposure& exposure : _pending_exposures){ _exposure_pending.erase(exposure.agent); }
+			_pending_exposures.clear();
+
+			std::stable_sort(_pending_status_changes.begin(), _pending_status_changes.end(),
+				[](const Pending_Status_Change& first, const Pending_Status_Change& second){ return first.agent < second.agent; });
+			for(const Pending_Status_Change& change : _pending_status_changes){ set_status(change.agent, change.new_status); }
+			_pending_status_changes.clear();
+		}
+
+		/*
+			Scheduled disease progression (see _transitions_due). With arrivals recorded, every agent whose status changes is noted
+				down; the simulation goes through them (status_arrivals), schedules the ones with somewhere to go next
+				(schedule_transition), and starts the list over (clear_status_arrivals). On each day, transitions_due gives the
+				agents due to move on, still in the status they were scheduled from.
+		*/
+		void record_status_arrivals(const bool recording) { _recording_arrivals = recording; }
+		const Agent_Range status_arrivals() const { return Agent_Range(_arrivals); }
+		void clear_status_arrivals() { _arrivals.clear(); }
+
+		// the agent is due to move on from their current status on the given day (it replaces anything scheduled for them before)
+		void schedule_transition(const int agent, const int day)
+		{
+			assert(check_agent_number(agent));
+			assert(day > _run_time);
+			if(day >= (int)_transitions_due.size()){ _transitions_due.resize(day+1); }
+			_transition_day[agent] = day;
+			_transitions_due[day].push_back(agent);
+		}
+
+		// the agents due to move on today
+		const Agent_Range transitions_due()
+		{
+			if(_run_time >= (int)_transitions_due.size()){ return Agent_Range(); }
+			Town_Vector<int>& today = _transitions_due[_run_time];
+			// drop anyone who's moved on (or been rescheduled) since
+			today.erase(std::remove_if(today.begin(), today.end(), [&](const int agent){ return _transition_day[agent] != _run_time; }), today.end());
+			return Agent_Range(today);
 		}
 
 		// change the classroom that the agent is assigned to
 		void set_classroom(const int agent_number, const int new_classroom, const int new_cohort)
 		{
 			assert(check_agent_number(agent_number));
-			assert(check_disease_status(_Population[agent_number].status()));
+			assert(check_disease_status(_agents._disease_status[agent_number]));
 
 			// only three possible cohorts in this model; it's every day, bro (0), week 1 (1) and week 2 (2)
 			assert( std::set<int>({-1,0,1,2}).count(new_cohort) );
 
-			Person* them = &_Population[agent_number];
+			const Person them = Agent(agent_number);
 
-			const int old_classroom = them->classroom();
-			const int old_cohort_number = them->cohort();
+			const int old_classroom = them.classroom();
+			const int old_cohort_number = them.cohort();
+			const int old_weeks_cohort = this_weeks_cohort();
 
 			/*
 				if the old classroom exists, take them out of it and change their individual characteristic
 				we need to check of the old one exists, since some of the objects will be initialised with
 					classroom Nan or -1
 			*/
-			if(_school.count(old_classroom))
+			if(_school.exists(old_classroom))
 			{
-				_school[old_classroom].erase(them->ID());
-				if(_school[old_classroom].empty()){ _school.erase(old_classroom); }
+				unseat(old_classroom, them.ID());
+				if(_school.members(old_classroom).empty()){ _school.remove(old_classroom); }
 			}
 
 			// set the new classroom and cohort characteristics
-			them->set_classroom(new_classroom);
-			them->set_cohort(new_cohort);
+			assign_classroom(agent_number, new_classroom);
+			_agents._cohort[agent_number] = new_cohort;
 
 			// mode from the old cohort to the new one
-			if(_the_cohorts.count(old_cohort_number)){ _the_cohorts[old_cohort_number].erase(agent_number); }
-			_the_cohorts[ them->cohort() ].insert( them->ID() );
+			_the_cohorts.erase(old_cohort_number, agent_number);
+			_the_cohorts.insert(them.cohort(), them.ID());
+
+			// move them to the new roster, and see whether they'll be in class
+			remove_from_roster(old_classroom, agent_number);
+			if(new_classroom != -1){ add_to_roster(new_classroom, agent_number); }
+			// starting up a second cohort changes who's in school this week
+			if(this_weeks_cohort() != old_weeks_cohort){ update_all_school_attendance(); }
+			else { update_school_attendance(agent_number); }
+			update_substitute_pool(agent_number); // in case they've just left the school altogether
 
 			// if they're eligible to be back in class this week, put them in the requested classroom
 			if(new_cohort != -1){ // they're on a cohort
-			if(not is_in_isolation(them->ID())){ // they're not isolating
-			if((them->cohort() == this_weeks_cohort()) or (them->cohort() == 0)) // either their cohort is in school this week, or they need to show up every day
+			if(not is_in_isolation(them.ID())){ // they're not isolating
+			if((them.cohort() == this_weeks_cohort()) or (them.cohort() == 0)) // either their cohort is in school this week, or they need to show up every day
 			{
-				_school[ them->classroom() ].insert(them->ID());
+				seat(them.classroom(), them.ID());
 			}}}
 
+			// if they're symptomatic or recovered, they may be waiting to get back into their new class
+			if(isolation_in_progress(agent_number)){ _isolation_in_progress.insert(agent_number); }
+			else { _isolation_in_progress.erase(agent_number); }
+		}
+
+		/*
+			Once the population is built, the agents get new IDs so that everyone in the same classroom (and cohort) is numbered
+				together, with the members of each household next to each other inside that, and then everyone not at the school
+				one household after another.
+
+			The transmission loops go through the agents in a classroom or a household over and over, so this way they walk
+				through a few neighbouring spots in each of the Agent_Store arrays and bitsets rather than all over them. The
+				numbers the agents were created with are kept (see external_ID) for anything that needs to refer to them.
+		*/
+		void renumber_agents_by_locality()
+		{
+			std::vector<int> in_new_order(_agent_IDs.begin(), _agent_IDs.end());
+			std::stable_sort(
+				in_new_order.begin(),
+				in_new_order.end(),
+				[&](const int first, const int second)
+				{
+					const int first_classr = _agents._classroom[first];
+					const int second_classr = _agents._classroom[second];
+					if((first_classr == -1) != (second_classr == -1)){ return second_classr == -1; } // school first
+					if(first_classr != second_classr){ return first_classr < second_classr; }
+					if(_agents._cohort[first] != _agents._cohort[second]){ return _agents._cohort[first] < _agents._cohort[second]; }
+					return _agents._household[first] < _agents._household[second];
+				}
+			);
+
+			std::vector<int> new_number_of(in_new_order.size());
+			for(int position = 0; position < (int)in_new_order.size(); ++position){ new_number_of[in_new_order[position]] = position; }
+			renumber_agents(new_number_of);
 		}
 
 		// place the agent in a house
 		void set_household(const int agent_number, const int new_household)
 		{
 			assert(check_agent_number(agent_number));
-			// get the old house number
-			const int old_household = _Population[agent_number].household();
-			// if it's not a default value, take them out of the old house
-			if(_households.count(old_household))
+			// move them; the household table is rebuilt from everyone's household the next time it's needed, and a house
+			// that nobody lives in anymore just drops out of it
+			if(_spreading_at_home.contains(agent_number))
 			{
-				_households[old_household].erase(agent_number);
-				if(_households[old_household].empty()){ _households.erase(old_household); }
+				add_home_pressure(agent_number, _agents._household[agent_number], -1);
+				add_home_pressure(agent_number, new_household, 1);
 			}
-			// put them in the new one
-			_households[new_household].insert(agent_number);
-			_Population[agent_number].set_household(new_household);
+			_agents._household[agent_number] = new_household;
+			_households_out_of_date = true;
 		}
 
 
@@ -1009,12 +2272,12 @@ class Town
 		void print_age_distribution()
 		{
 			std::cout << "Age distribution of the population:\n";
-			std::cout << "\tNumber of children: " << std::accumulate(_Population.begin(), _Population.end(), 0, [&](int accumulator, Person agent){ return accumulator+(agent.age()=='C'); } ) << '\n';
-			std::cout << "\tNumber of adults: " << std::accumulate(_Population.begin(), _Population.end(), 0, [&](int accumulator, Person agent){ return accumulator+(agent.age()=='A'); } ) << '\n';
+			std::cout << "\tNumber of children: " << std::accumulate(_agents._age.begin(), _agents._age.end(), 0, [&](int accumulator, char age){ return accumulator+(age=='C'); } ) << '\n';
+			std::cout << "\tNumber of adults: " << std::accumulate(_agents._age.begin(), _agents._age.end(), 0, [&](int accumulator, char age){ return accumulator+(age=='A'); } ) << '\n';
 			std::cout << "\tNumber of other: " << std::accumulate(
-				_Population.begin(),
-				_Population.end(), 0,
-				[&](int accumulator, Person agent){ return accumulator+((agent.age()!='C') & (agent.age()!='A')); }
+				_agents._age.begin(),
+				_agents._age.end(), 0,
+				[&](int accumulator, char age){ return accumulator+((age!='C') & (age!='A')); }
 			) << '\n';
 		}
 
@@ -1022,24 +2285,24 @@ class Town
 		void print_households()
 		{
 			std::cout << "\nNumber of households: " << num_households() << std::endl;
-			for(std::pair<int, std::set<int>> house : households())
+			for(const std::pair<int, Agent_Range> house : households())
 			{
 				if(house.first == -1) continue;
 
 				std::cout << "\tHouse #" << house.first << " :\n";
 				std::cout << "\t\tChildren: ";
 
-				for(int child : house.second){ if(_Population[child].age() == 'C')
+				for(int child : house.second){ if(_agents._age[child] == 'C')
 				{
-					const Person* them = &_Population[child];
-					if(them->classroom() == -1){ printf("[%i, %c], ", them->ID(), them->status()); }
+					const Person them = Agent(child);
+					if(them.classroom() == -1){ printf("[%i, %c], ", them.ID(), them.status()); }
 					else
 					{
 						std::stringstream blurb;
-						blurb << "[" << them->ID() << ", status " << them->status() << ", class " <<  them->classroom();
+						blurb << "[" << them.ID() << ", status " << them.status() << ", class " <<  them.classroom();
 						if(
-							std::set<char>({'I', 'R'}).count(them->status()) and
-							(is_in_isolation(them->ID()))
+							Disease.off_sick[status_index(them.status())] and
+							(is_in_isolation(them.ID()))
 						)
 						{ blurb << ", out sick]"; }
 						else { blurb << "]"; }
@@ -1047,21 +2310,21 @@ class Town
 					}
 				}}
 				std::cout << "\n\t\tAdults: ";
-				for(int adult : house.second){ if(_Population[adult].age() == 'A')
+				for(int adult : house.second){ if(_agents._age[adult] == 'A')
 				{
-					const Person* them = &_Population[adult];
+					const Person them = Agent(adult);
 
-					if(them->classroom() == -1){ printf("[%i, %c], ", them->ID(), them->status()); }
+					if(them.classroom() == -1){ printf("[%i, %c], ", them.ID(), them.status()); }
 					else
 					{
 						std::stringstream blurb;
-						blurb << "[" << them->ID() << ", status " << them->status() << ", class " <<  them->classroom();
+						blurb << "[" << them.ID() << ", status " << them.status() << ", class " <<  them.classroom();
 						if(
-							std::set<char>({'I', 'R'}).count(them->status()) &
-							(is_in_isolation(them->ID()))
+							Disease.off_sick[status_index(them.status())] &
+							(is_in_isolation(them.ID()))
 						)
 						{ blurb << ", out sick]"; }
-						else if(set_of_values(_substitute_list_OGs_first).count(them->ID())){ blurb << ", substitute]"; }
+						else if(is_substitute(them.ID())){ blurb << ", substitute]"; }
 						else { blurb << "]"; }
 						printf("%s, ", blurb.str().c_str());
 					}
@@ -1079,23 +2342,23 @@ class Town
 				return;
 			}
 
-			std::pair<int, std::set<int>> classr({room_number, classroom(room_number)});
-			if(classr.first == -1) return;
+			const Agent_Range the_class = classroom(room_number);
+			if(room_number == -1) return;
 			if(classroom_closed_due_to_infection(room_number)){ printf("Classroom shut down.\n"); return; }
 
-			std::cout << "\tClassroom #" << classr.first << " :\n";
+			std::cout << "\tClassroom #" << room_number << " :\n";
 
-			std::cout << "\t\t # children: " << children_in_classroom(classr.first).size() << ", # teachers: " << teachers_in_classroom(classr.first).size();
+			std::cout << "\t\t # children: " << children_in_classroom(room_number).size() << ", # teachers: " << teachers_in_classroom(room_number).size();
 			std::cout << "\n\t\tChildren: ";
 
-			for(int child : classr.second){ if(_Population[child].age() == 'C')
+			for(int child : the_class){ if(_agents._age[child] == 'C')
 			{
 				std::stringstream blurb;
 
-				blurb << "[" << child << ", status " << _Population[child].status() << ", house " <<  _Population[child].household() << ", cohort " << _Population[child].cohort();
-				if( std::set<char>({'I', 'R'}).count(_Population[child].status()) )
+				blurb << "[" << child << ", status " << _agents._disease_status[child] << ", house " <<  _agents._household[child] << ", cohort " << (int)_agents._cohort[child];
+				if( Disease.off_sick[status_index(_agents._disease_status[child])] )
 				{
-					if(_Population[child].days_since_first_symptoms() >= 14){ blurb << ", recovered"; }
+					if(_agents._days_since_first_symptoms[child] >= 14){ blurb << ", recovered"; }
 					else if(is_in_isolation(child)){ blurb << ", out sick"; }
 				}
 				blurb << "]";
@@ -1104,17 +2367,17 @@ class Town
 
 			std::cout << "\n\t\tTeachers: ";
 
-			for(int adult : classr.second){ if(_Population[adult].age() == 'A')
+			for(int adult : the_class){ if(_agents._age[adult] == 'A')
 			{
 				std::stringstream blurb;
 
-				blurb << "[" << adult << ", status " << _Population[adult].status() << ", house " <<  _Population[adult].household() << ", cohort " << _Population[adult].cohort();
-				if( std::set<char>({'I', 'R'}).count(_Population[adult].status()) )
+				blurb << "[" << adult << ", status " << _agents._disease_status[adult] << ", house " <<  _agents._household[adult] << ", cohort " << (int)_agents._cohort[adult];
+				if( Disease.off_sick[status_index(_agents._disease_status[adult])] )
 				{
-					if(_Population[adult].days_since_first_symptoms() >= 14){ blurb << ", recovered"; }
+					if(_agents._days_since_first_symptoms[adult] >= 14){ blurb << ", recovered"; }
 					else if(is_in_isolation(adult)){ blurb << ", out sick"; }
 				}
-				else if(set_of_values(_substitute_list_OGs_first).count(adult)){ blurb << ", substitute"; }
+				else if(is_substitute(adult)){ blurb << ", substitute"; }
 				blurb << "]";
 				printf("\n\t\t\t%s, ", blurb.str().c_str());
 			}}
@@ -1135,7 +2398,7 @@ class Town
 				return;
 			}
 			std::cout << "\nNumber of classrooms: " << num_classrooms() << std::endl;
-			for(std::pair<int, std::set<int>> classr : classrooms())
+			for(const std::pair<int, Agent_Range> classr : classrooms())
 			{
 				if(classr.first == -1) continue;
 
@@ -1144,13 +2407,13 @@ class Town
 
 				std::cout << "\t\t# children: " << children_in_classroom(classr.first).size() << ", # teachers: " << teachers_in_classroom(classr.first).size();
 				std::cout << "\n\t\tChildren:";
-				for(int child : classr.second){ if(_Population[child].age() == 'C')
+				for(int child : classr.second){ if(_agents._age[child] == 'C')
 				{
 					std::stringstream blurb;
-					blurb << "\n\t\t\t[" << child << ", status " << _Population[child].status() << ", house " <<  _Population[child].household() << ", cohort " << _Population[child].cohort();
-					if( std::set<char>({'I', 'R'}).count(_Population[child].status()) )
+					blurb << "\n\t\t\t[" << child << ", status " << _agents._disease_status[child] << ", house " <<  _agents._household[child] << ", cohort " << (int)_agents._cohort[child];
+					if( Disease.off_sick[status_index(_agents._disease_status[child])] )
 					{
-						if(_Population[child].days_since_first_symptoms() < 14) { blurb << ", out sick]"; }
+						if(_agents._days_since_first_symptoms[child] < 14) { blurb << ", out sick]"; }
 						else { blurb << ", recovered]"; }
 					}
 					else { blurb << "]"; }
@@ -1158,16 +2421,16 @@ class Town
 				}}
 
 				std::cout << "\n\t\tTeachers:";
-				for(int adult : classr.second){ if(_Population[adult].age() == 'A')
+				for(int adult : classr.second){ if(_agents._age[adult] == 'A')
 				{
 					std::stringstream blurb;
-					blurb << "\n\t\t\t[" << adult << ", status " << _Population[adult].status() << ", house " <<  _Population[adult].household() << ", cohort " << _Population[adult].cohort();
-					if( std::set<char>({'I', 'R'}).count(_Population[adult].status()) )
+					blurb << "\n\t\t\t[" << adult << ", status " << _agents._disease_status[adult] << ", house " <<  _agents._household[adult] << ", cohort " << (int)_agents._cohort[adult];
+					if( Disease.off_sick[status_index(_agents._disease_status[adult])] )
 					{
-						if(_Population[adult].days_since_first_symptoms() < 14) { blurb << ", out sick]"; }
+						if(_agents._days_since_first_symptoms[adult] < 14) { blurb << ", out sick]"; }
 						else { blurb << ", recovered]"; }
 					}
-					else if(set_of_values(_substitute_list_OGs_first).count(adult)){ blurb << ", substitute]"; }
+					else if(is_substitute(adult)){ blurb << ", substitute]"; }
 					else { blurb << "]"; }
 					printf("%s, ", blurb.str().c_str());
 				}}
@@ -1180,10 +2443,11 @@ class Town
 		void print_compartments()
 		{
 			std::cout << "Disease compartments:\n";
-			for(std::pair<char, std::set<int>> pair : _disease_compartments)
+			for(int state = 0; state < Num_Disease_Statuses; ++state)
 			{
-				std::cout << "\t" << pair.first << " : ";
-				for(int person : pair.second){ std::cout << ", " << _Population[person].ID(); }
+				if(not _compartment_in_use[state]){ continue; }
+				std::cout << "\t" << Disease_Status_Names[state] << " : ";
+				for(int person : _disease_compartments[state]){ std::cout << ", " << person; }
 				std::cout << "\n";
 			}
 		}
@@ -1192,35 +2456,247 @@ class Town
 		void print_compartment_sizes()
 		{
 			std::cout << "Disease compartment sizes:\n";
-			for(std::pair<char, std::set<int>> pair : _disease_compartments)
+			for(int state = 0; state < Num_Disease_Statuses; ++state)
 			{
-				std::cout << "\t" << pair.first << ": " << pair.second.size() << std::endl;
+				if(not _compartment_in_use[state]){ continue; }
+				std::cout << "\t" << Disease_Status_Names[state] << ": " << _disease_compartments[state].size() << std::endl;
 			}
 			std::cout << "\n";
 		}
 
+		// the containers all start out empty, on the Town's arena
 		Town()
 		{
-			_Population = {};
-			_agent_IDs = {};
-			_households = {};
-			_school = {};
-			_disease_compartments = {};
-			_run_time = 0;
+			reset();
+		}
+
+		/*
+			Forking: a copy of a Town is a complete, independent copy of its state (agents, households, school, closures,
+				substitutes, infections, and the random numbers for making substitute households), built on the new Town's
+				own arena. Carrying on with the copy gives the same run the original would have had (as long as they're fed
+				the same random numbers), so it's a cheap way to branch several continuations off one point of a simulation -
+				right after the population's been made, say, or at the first closure - instead of simulating the common
+				prefix over again for every one of them.
+
+			Assigning a Town to another one throws out whatever the target held and keeps its storage, like reset().
+		*/
+		Town(const Town& other)
+		{
+			reset();
+			*this = other;
 		}
 
-		Town(Town& other)
+		Town& operator = (const Town& other)
 		{
-			_Population = other._Population;
-			_households = other._households,
+			if(this == &other){ return *this; }
+			_agents = other._agents;
+			_agent_IDs = other._agent_IDs;
+			_external_IDs = other._external_IDs;
+			_households = other._households;
+			_households_out_of_date = other._households_out_of_date;
 			_school = other._school;
+			_closure_ledger = other._closure_ledger;
+			_current_closure = other._current_closure;
+			_num_closed_classrooms = other._num_closed_classrooms;
+			_child_closure_days_so_far = other._child_closure_days_so_far;
+			_reopenings_due = other._reopenings_due;
+			_substitute_list_OGs_first = other._substitute_list_OGs_first;
+			_OG_teacher_of = other._OG_teacher_of;
+			_substitute_pool = other._substitute_pool;
+			_num_assigned_to_school = other._num_assigned_to_school;
+			_assigned_a_classroom = other._assigned_a_classroom;
+			_available_substitutes = other._available_substitutes;
+			_reserve_ages = other._reserve_ages;
+			_reserve_statuses = other._reserve_statuses;
+			_reserve_offsets = other._reserve_offsets;
+			_reserve_made = other._reserve_made;
+			_substitute_households_in_reserve = other._substitute_households_in_reserve;
+			_reserve_in_status = other._reserve_in_status;
+			_reserve_adults = other._reserve_adults;
+			_reserve_children = other._reserve_children;
+			_reserve_generator = other._reserve_generator;
 			_disease_compartments = other._disease_compartments;
+			_compartment_in_use = other._compartment_in_use;
 			_run_time = other._run_time;
+			_the_cohorts = other._the_cohorts;
+			_places_infected = other._places_infected;
+			_class_rosters = other._class_rosters;
+			_school_attendees = other._school_attendees;
+			_num_in_school = other._num_in_school;
+			_children_kept_home = other._children_kept_home;
+			_isolation_in_progress = other._isolation_in_progress;
+			_exposure_pending = other._exposure_pending;
+			_has_a_classroom = other._has_a_classroom;
+			_pending_exposures = other._pending_exposures;
+			_pending_status_changes = other._pending_status_changes;
+			_recording_arrivals = other._recording_arrivals;
+			_arrivals = other._arrivals;
+			_transition_day = other._transition_day;
+			_transitions_due = other._transitions_due;
+			_num_adults = other._num_adults;
+			_num_children = other._num_children;
+			// the masks are kept on this Town's arena, so they're set up again rather than copied over (and the household pressure with them)
+			_classroom_slots.clear();
+			rebuild_all_classroom_slots();
+			rebuild_home_pressure();
+			return *this;
+		}
+
+		/*
+			Snapshots: serialize writes the complete state of the Town to a binary stream (open it with std::ios::binary), and
+				deserialize reads one back in, replacing whatever the Town held. Same contents as a fork, so the Town picks up
+				exactly where the snapshot was taken; handy for looking at a strange instance offline, or for starting a batch of
+				runs from a saved population. The layout is the machine's own (see write_binary), so read snapshots back with
+				the same build that wrote them.
+		*/
+		void serialize(std::ostream& out) const
+		{
+			out.write(Snapshot_Tag, sizeof(Snapshot_Tag));
+			write_binary(out, Snapshot_Version);
+			write_binary(out, _agents._age);
+			write_binary(out, _agents._disease_status);
+			write_binary(out, _agents._cohort);
+			write_binary(out, _agents._infection_locale);
+			write_binary(out, _agents._days_since_first_symptoms);
+			write_binary(out, _agents._classroom);
+			write_binary(out, _agents._household);
+			write_binary(out, _agents._time_step_infected_at);
+			write_binary(out, _agents._infected_by);
+			write_binary(out, _agents._num_infected);
+			write_binary(out, _agent_IDs);
+			write_binary(out, _external_IDs);
+			write_binary(out, _households);
+			write_binary(out, _households_out_of_date);
+			write_binary(out, _school);
+			write_binary(out, _closure_ledger);
+			write_binary(out, _current_closure);
+			write_binary(out, _num_closed_classrooms);
+			write_binary(out, _child_closure_days_so_far);
+			write_binary(out, _reopenings_due);
+			write_binary(out, _substitute_list_OGs_first);
+			write_binary(out, _OG_teacher_of);
+			write_binary(out, _substitute_pool);
+			write_binary(out, _num_assigned_to_school);
+			write_binary(out, _assigned_a_classroom);
+			write_binary(out, _available_substitutes);
+			write_binary(out, _reserve_ages);
+			write_binary(out, _reserve_statuses);
+			write_binary(out, _reserve_offsets);
+			write_binary(out, _reserve_made);
+			write_binary(out, _substitute_households_in_reserve);
+			write_binary(out, _reserve_in_status);
+			write_binary(out, _reserve_adults);
+			write_binary(out, _reserve_children);
+			std::ostringstream generator_state;
+			generator_state << _reserve_generator;
+			write_binary(out, generator_state.str());
+			write_binary(out, _disease_compartments);
+			write_binary(out, _compartment_in_use);
+			write_binary(out, _run_time);
+			write_binary(out, _the_cohorts);
+			write_binary(out, _places_infected);
+			write_binary(out, _class_rosters);
+			write_binary(out, _school_attendees);
+			write_binary(out, _num_in_school);
+			write_binary(out, _children_kept_home);
+			write_binary(out, _isolation_in_progress);
+			write_binary(out, _exposure_pending);
+			write_binary(out, _has_a_classroom);
+			write_binary(out, _pending_exposures);
+			write_binary(out, _pending_status_changes);
+			write_binary(out, _recording_arrivals);
+			write_binary(out, _arrivals);
+			write_binary(out, _transition_day);
+			write_binary(out, _transitions_due);
+			write_binary(out, _num_adults);
+			write_binary(out, _num_children);
+		}
+
+		void deserialize(std::istream& in)
+		{
+			reset();
+
+			char tag[sizeof(Snapshot_Tag)] = {};
+			int version = -1;
+			in.read(tag, sizeof(Snapshot_Tag));
+			read_binary(in, version);
+			if((not in) or (not std::equal(tag, tag+sizeof(Snapshot_Tag), Snapshot_Tag)) or (version != Snapshot_Version))
+			{
+				std::cerr << "\n###### NOT A TOWN SNAPSHOT (or one from a different version of the Town). ######" << std::endl;
+				std::exit(EXIT_FAILURE);
+			}
+
+			read_binary(in, _agents._age);
+			read_binary(in, _agents._disease_status);
+			read_binary(in, _agents._cohort);
+			read_binary(in, _agents._infection_locale);
+			read_binary(in, _agents._days_since_first_symptoms);
+			read_binary(in, _agents._classroom);
+			read_binary(in, _agents._household);
+			read_binary(in, _agents._time_step_infected_at);
+			read_binary(in, _agents._infected_by);
+			read_binary(in, _agents._num_infected);
+			read_binary(in, _agent_IDs);
+			read_binary(in, _external_IDs);
+			read_binary(in, _households);
+			read_binary(in, _households_out_of_date);
+			read_binary(in, _school);
+			read_binary(in, _closure_ledger);
+			read_binary(in, _current_closure);
+			read_binary(in, _num_closed_classrooms);
+			read_binary(in, _child_closure_days_so_far);
+			read_binary(in, _reopenings_due);
+			read_binary(in, _substitute_list_OGs_first);
+			read_binary(in, _OG_teacher_of);
+			read_binary(in, _substitute_pool);
+			read_binary(in, _num_assigned_to_school);
+			read_binary(in, _assigned_a_classroom);
+			read_binary(in, _available_substitutes);
+			read_binary(in, _reserve_ages);
+			read_binary(in, _reserve_statuses);
+			read_binary(in, _reserve_offsets);
+			read_binary(in, _reserve_made);
+			read_binary(in, _substitute_households_in_reserve);
+			read_binary(in, _reserve_in_status);
+			read_binary(in, _reserve_adults);
+			read_binary(in, _reserve_children);
+			std::string generator_state;
+			read_binary(in, generator_state);
+			std::istringstream(generator_state) >> _reserve_generator;
+			read_binary(in, _disease_compartments);
+			read_binary(in, _compartment_in_use);
+			read_binary(in, _run_time);
+			read_binary(in, _the_cohorts);
+			read_binary(in, _places_infected);
+			read_binary(in, _class_rosters);
+			read_binary(in, _school_attendees);
+			read_binary(in, _num_in_school);
+			read_binary(in, _children_kept_home);
+			read_binary(in, _isolation_in_progress);
+			read_binary(in, _exposure_pending);
+			read_binary(in, _has_a_classroom);
+			read_binary(in, _pending_exposures);
+			read_binary(in, _pending_status_changes);
+			read_binary(in, _recording_arrivals);
+			read_binary(in, _arrivals);
+			read_binary(in, _transition_day);
+			read_binary(in, _transitions_due);
+			read_binary(in, _num_adults);
+			read_binary(in, _num_children);
+
+			if(not in)
+			{
+				std::cerr << "\n###### TOWN SNAPSHOT CUT SHORT. Couldn't read the whole Town back in. ######" << std::endl;
+				std::exit(EXIT_FAILURE);
+			}
+			rebuild_all_classroom_slots();
+			rebuild_home_pressure();
 		}
 
-		auto compartments()
+		// view of all the compartments that have been used. First - disease status. Second - bitset of the agents with that status
+		const Compartment_List_View compartments() const
 		{
-			return _disease_compartments;
+			return Compartment_List_View(&_disease_compartments, &_compartment_in_use);
 		}
 
 		void print_substitute_list()
@@ -0,0 +1,882 @@
+#ifndef REAL_TOWN_CONTAINERS_HPP_
+#define REAL_TOWN_CONTAINERS_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <iterator>
+#include <initializer_list>
+#include <algorithm>
+#include <utility>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <array>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <random>
+#ifndef TOWN_DEFAULT_ALLOCATOR
+#include <memory_resource>
+#endif
+#include "prettyprint.hpp"
+
+/*
+	Where the Town keeps its storage.
+
+	Every Town owns an arena that all of its containers allocate from: a pool of recycled blocks, drawing on a monotonic buffer.
+		Nothing is handed back to the buffer until the Town is destroyed, and then the whole lot goes in one shot, instead of
+		thousands of separate frees; and with one arena per Town, the threads running instances side by side don't fight
+		over the global heap. The pool is there because a Town is reused from one instance to the next (see Town::reset()):
+		the nodes of the maps are freed and allocated again every instance, and a bare monotonic buffer would never give
+		that memory back, so it would keep growing for as long as the Town was in use.
+
+	Compile with -DTOWN_DEFAULT_ALLOCATOR to put everything back on the plain std::allocator (the arena is then an empty
+		stand-in) to compare the two.
+*/
+#ifndef TOWN_DEFAULT_ALLOCATOR
+
+	// the buffer has to be built before the pool that draws on it, and base classes are built before members, hence the extra base
+	struct Town_Arena_Buffer
+	{
+		std::pmr::monotonic_buffer_resource _buffer;
+		Town_Arena_Buffer(const std::size_t initial_size) : _buffer(initial_size) {}
+	};
+	class Town_Arena : private Town_Arena_Buffer, public std::pmr::unsynchronized_pool_resource
+	{
+		public:
+			Town_Arena(const std::size_t initial_size) : Town_Arena_Buffer(initial_size), std::pmr::unsynchronized_pool_resource(&_buffer) {}
+	};
+	template<typename T> using Town_Allocator = std::pmr::polymorphic_allocator<T>;
+
+#else
+
+	struct Town_Arena
+	{
+		Town_Arena(const std::size_t /* initial_size */ = 0) {}
+	};
+	// std::allocator that can be built from (and then ignores) an arena, so the containers are set up the same way either way
+	template<typename T> struct Town_Allocator : std::allocator<T>
+	{
+		template<typename U> struct rebind { typedef Town_Allocator<U> other; };
+		Town_Allocator() {}
+		Town_Allocator(Town_Arena* /* arena */) {}
+		template<typename U> Town_Allocator(const Town_Allocator<U>&) {}
+	};
+
+#endif
+
+template<typename T> using Town_Vector = std::vector<T, Town_Allocator<T>>;
+template<typename K, typename V> using Town_Map = std::map<K, V, std::less<K>, Town_Allocator<std::pair<const K, V>>>;
+
+/*
+	Writing the Town's state out to a binary stream, and reading it back in (see Town::serialize).
+
+	Plain values (numbers, and structs of numbers with no padding between them) go out as their raw bytes, and containers as
+		their size followed by their elements; the Town's own containers, and structs with padding, write themselves out with
+		serialize(), so no stray bytes end up in a snapshot. It's the machine's own layout, so a snapshot is for picking a Town
+		back up on the same build, not for passing between machines.
+
+	Reading only checks the sizes of the containers, against what's left of the stream (see read_size), so the stream has to
+		be one that can tell (a file or a stringstream); Town::deserialize checks the stream once it's done.
+*/
+template<typename T> constexpr bool Written_Raw = std::is_arithmetic<T>::value or std::is_enum<T>::value
+	or (std::is_trivially_copyable<T>::value and std::has_unique_object_representations<T>::value);
+
+template<typename T> void write_binary(std::ostream& out, const T& value)
+{
+	if constexpr(Written_Raw<T>){ out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+	else { value.serialize(out); }
+}
+template<typename T> void read_binary(std::istream& in, T& value)
+{
+	if constexpr(Written_Raw<T>){ in.read(reinterpret_cast<char*>(&value), sizeof(T)); }
+	else { value.deserialize(in); }
+}
+
+/*
+	reads the size of a container, each of whose elements takes up at least bytes_each of the stream. a size that's negative, or
+		more than what's left of the stream could hold, fails the stream (and gives 0), instead of the container making room for it
+*/
+inline std::int64_t read_size(std::istream& in, const std::int64_t bytes_each)
+{
+	std::int64_t size = 0;
+	read_binary(in, size);
+	if(not in){ return 0; }
+
+	const std::streampos here = in.tellg();
+	in.seekg(0, std::ios::end);
+	const std::streamoff bytes_left = in.tellg() - here;
+	in.seekg(here);
+	if((not in) or (size < 0) or (size > bytes_left/bytes_each))
+	{
+		in.setstate(std::ios::failbit);
+		return 0;
+	}
+	return size;
+}
+
+template<typename T, typename Allocator> void write_binary(std::ostream& out, const std::vector<T, Allocator>& values)
+{
+	write_binary(out, (std::int64_t)values.size());
+	if constexpr(Written_Raw<T>){ out.write(reinterpret_cast<const char*>(values.data()), values.size()*sizeof(T)); }
+	else { for(const T& value : values){ write_binary(out, value); } }
+}
+template<typename T, typename Allocator> void read_binary(std::istream& in, std::vector<T, Allocator>& values)
+{
+	const std::int64_t size = read_size(in, Written_Raw<T> ? sizeof(T) : 1);
+	values.resize(size);
+	if constexpr(Written_Raw<T>){ in.read(reinterpret_cast<char*>(values.data()), values.size()*sizeof(T)); }
+	else { for(T& value : values){ read_binary(in, value); } }
+}
+
+template<typename T, std::size_t N> void write_binary(std::ostream& out, const std::array<T, N>& values)
+{
+	for(const T& value : values){ write_binary(out, value); }
+}
+template<typename T, std::size_t N> void read_binary(std::istream& in, std::array<T, N>& values)
+{
+	for(T& value : values){ read_binary(in, value); }
+}
+
+// (std::pair isn't trivially copyable, since it has its own assignment)
+template<typename T, typename U> void write_binary(std::ostream& out, const std::pair<T, U>& the_pair)
+{
+	write_binary(out, the_pair.first);
+	write_binary(out, the_pair.second);
+}
+template<typename T, typename U> void read_binary(std::istream& in, std::pair<T, U>& the_pair)
+{
+	read_binary(in, the_pair.first);
+	read_binary(in, the_pair.second);
+}
+
+template<typename K, typename V, typename Compare, typename Allocator> void write_binary(std::ostream& out, const std::map<K, V, Compare, Allocator>& the_map)
+{
+	write_binary(out, (std::int64_t)the_map.size());
+	for(const std::pair<const K, V>& element : the_map){ write_binary(out, element.first); write_binary(out, element.second); }
+}
+template<typename K, typename V, typename Compare, typename Allocator> void read_binary(std::istream& in, std::map<K, V, Compare, Allocator>& the_map)
+{
+	const std::int64_t size = read_size(in, 1);
+	the_map.clear();
+	for(std::int64_t element = 0; (element < size) and in; ++element)
+	{
+		K key;
+		V value;
+		read_binary(in, key);
+		read_binary(in, value);
+		the_map.emplace_hint(the_map.end(), key, value);
+	}
+}
+
+template<typename K, typename Compare, typename Allocator> void write_binary(std::ostream& out, const std::set<K, Compare, Allocator>& the_set)
+{
+	write_binary(out, (std::int64_t)the_set.size());
+	for(const K& element : the_set){ write_binary(out, element); }
+}
+template<typename K, typename Compare, typename Allocator> void read_binary(std::istream& in, std::set<K, Compare, Allocator>& the_set)
+{
+	const std::int64_t size = read_size(in, 1);
+	the_set.clear();
+	for(std::int64_t element = 0; (element < size) and in; ++element)
+	{
+		K key;
+		read_binary(in, key);
+		the_set.emplace_hint(the_set.end(), key);
+	}
+}
+
+inline void write_binary(std::ostream& out, const std::string& text)
+{
+	write_binary(out, (std::int64_t)text.size());
+	out.write(text.data(), text.size());
+}
+inline void read_binary(std::istream& in, std::string& text)
+{
+	const std::int64_t size = read_size(in, 1);
+	text.resize(size);
+	in.read(&text[0], size);
+}
+
+/*
+	Dense set of agent IDs, one bit per agent in the Town.
+
+	Membership changes are a single bit flip, and iterating over the set walks the words in order, so agents always come out
+		sorted by ID (same order as a std::set<int> would give them). The number of members is kept up to date as agents are
+		inserted and erased, so size() doesn't need to count anything.
+*/
+class Agent_Bitset
+{
+	private:
+
+		Town_Vector<std::uint64_t> _words;
+		int _count = 0;
+
+	public:
+
+		Agent_Bitset() {}
+		explicit Agent_Bitset(Town_Arena* arena) : _words(arena) {}
+
+		class const_iterator
+		{
+			private:
+
+				const Agent_Bitset* _set;
+				int _word_index;
+				std::uint64_t _bits; // what's left of the current word to visit
+
+				void skip_empty_words()
+				{
+					while((_bits == 0) and (++_word_index < _set->num_words())){ _bits = _set->word(_word_index); }
+				}
+
+			public:
+
+				typedef std::forward_iterator_tag iterator_category;
+				typedef int value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const int* pointer;
+				typedef int reference;
+
+				const_iterator(const Agent_Bitset* the_set, const int word_index) : _set(the_set), _word_index(word_index), _bits(0)
+				{
+					if(_word_index < _set->num_words()){ _bits = _set->word(_word_index); skip_empty_words(); }
+				}
+
+				int operator * () const { return 64*_word_index + __builtin_ctzll(_bits); }
+				const_iterator& operator ++ () { _bits &= _bits - 1; skip_empty_words(); return *this; }
+				const_iterator operator ++ (int) { const_iterator old = *this; ++(*this); return old; }
+				// every iterator that has run out of bits is the end, even if the set grew while we were looping
+				bool operator == (const const_iterator& other) const { return (_bits == other._bits) and ((_bits == 0) or (_word_index == other._word_index)); }
+				bool operator != (const const_iterator& other) const { return not (*this == other); }
+		};
+		typedef const_iterator iterator;
+		typedef int value_type;
+
+		// make room for agents numbered 0 to num_agents-1
+		void resize(const int num_agents)
+		{
+			const int words_needed = (num_agents + 63)/64;
+			if(words_needed > (int)_words.size()){ _words.resize(words_needed, 0); }
+		}
+
+		const bool contains(const int agent) const
+		{
+			return (agent >= 0) and (agent/64 < (int)_words.size()) and ((_words[agent/64] >> (agent%64)) & 1);
+		}
+
+		void insert(const int agent)
+		{
+			const std::uint64_t bit = std::uint64_t(1) << (agent%64);
+			_count += not (_words[agent/64] & bit);
+			_words[agent/64] |= bit;
+		}
+
+		void erase(const int agent)
+		{
+			const std::uint64_t bit = std::uint64_t(1) << (agent%64);
+			_count -= not not (_words[agent/64] & bit);
+			_words[agent/64] &= ~bit;
+		}
+
+		// empties the set but keeps the storage
+		void clear()
+		{
+			std::fill(_words.begin(), _words.end(), 0);
+			_count = 0;
+		}
+
+		// empties the set and shrinks it back to no agents at all, but still keeps the storage (resize() before using it again)
+		void reset()
+		{
+			_words.clear();
+			_count = 0;
+		}
+
+		// move every member to their new number (new_number_of[old number] = new number)
+		void renumber(const std::vector<int>& new_number_of)
+		{
+			const Agent_Bitset old_members = *this;
+			clear();
+			for(const int agent : old_members){ insert(new_number_of[agent]); }
+		}
+
+		void serialize(std::ostream& out) const { write_binary(out, _words); write_binary(out, _count); }
+		void deserialize(std::istream& in) { read_binary(in, _words); read_binary(in, _count); }
+
+		const int size() const { return _count; }
+		const bool empty() const { return _count == 0; }
+		const int num_words() const { return _words.size(); }
+		const std::uint64_t word(const int index) const { return _words[index]; }
+
+		/*
+			Iterators read the words as they go, so it's fine to erase agents from the set while looping over it (the current
+				word has already been read). Agents inserted further along will be visited.
+		*/
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, num_words()); }
+};
+
+/*
+	Read-only view of the union of a few disjoint Agent_Bitsets (the members of several disease compartments, for example),
+		optionally restricted to the members of another bitset, or leaving out the members of another one.
+
+	Nothing is copied or allocated: the view keeps pointers to the bitsets and ORs (and ANDs) the words together while
+		iterating, so agents still come out sorted by ID. Like the Agent_Bitset iterators, it reads the sets as it goes.
+*/
+class Agent_Group
+{
+	public:
+
+		static const int Max_Sets = 8;
+
+	private:
+
+		const Agent_Bitset* _sets[Max_Sets];
+		int _num_sets;
+		const Agent_Bitset* _mask; // only agents in this set are visited, if given
+		const Agent_Bitset* _excluded; // agents in this set are never visited, if given
+
+	public:
+
+		class const_iterator
+		{
+			private:
+
+				const Agent_Group* _group;
+				int _word_index;
+				std::uint64_t _bits;
+
+				void skip_empty_words()
+				{
+					while((_bits == 0) and (++_word_index < _group->num_words())){ _bits = _group->word(_word_index); }
+				}
+
+			public:
+
+				typedef std::forward_iterator_tag iterator_category;
+				typedef int value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const int* pointer;
+				typedef int reference;
+
+				const_iterator(const Agent_Group* group, const int word_index) : _group(group), _word_index(word_index), _bits(0)
+				{
+					if(_word_index < _group->num_words()){ _bits = _group->word(_word_index); skip_empty_words(); }
+				}
+
+				int operator * () const { return 64*_word_index + __builtin_ctzll(_bits); }
+				const_iterator& operator ++ () { _bits &= _bits - 1; skip_empty_words(); return *this; }
+				const_iterator operator ++ (int) { const_iterator old = *this; ++(*this); return old; }
+				// every iterator that has run out of bits is the end, even if the set grew while we were looping
+				bool operator == (const const_iterator& other) const { return (_bits == other._bits) and ((_bits == 0) or (_word_index == other._word_index)); }
+				bool operator != (const const_iterator& other) const { return not (*this == other); }
+		};
+		typedef const_iterator iterator;
+		typedef int value_type;
+
+		Agent_Group() : _num_sets(0), _mask(nullptr), _excluded(nullptr) {}
+
+		// add the members of another (disjoint) bitset to the view
+		void add(const Agent_Bitset* the_set)
+		{
+			_sets[_num_sets++] = the_set;
+		}
+
+		// only show the agents that are also in this bitset
+		void restrict_to(const Agent_Bitset* mask)
+		{
+			_mask = mask;
+		}
+
+		// don't show the agents in this bitset
+		void exclude(const Agent_Bitset* excluded)
+		{
+			_excluded = excluded;
+		}
+
+		const int num_words() const
+		{
+			int num = 0;
+			for(int index = 0; index < _num_sets; ++index){ num = std::max(num, _sets[index]->num_words()); }
+			if(_mask != nullptr){ num = std::min(num, _mask->num_words()); }
+			return num;
+		}
+
+		const std::uint64_t word(const int index) const
+		{
+			std::uint64_t the_word = 0;
+			for(int set = 0; set < _num_sets; ++set){ if(index < _sets[set]->num_words()){ the_word |= _sets[set]->word(index); } }
+			if(_mask != nullptr){ the_word &= _mask->word(index); }
+			if((_excluded != nullptr) and (index < _excluded->num_words())){ the_word &= ~_excluded->word(index); }
+			return the_word;
+		}
+
+		const bool contains(const int agent) const
+		{
+			if((_mask != nullptr) and (not _mask->contains(agent))){ return false; }
+			if((_excluded != nullptr) and _excluded->contains(agent)){ return false; }
+			for(int set = 0; set < _num_sets; ++set){ if(_sets[set]->contains(agent)){ return true; } }
+			return false;
+		}
+
+		// number of agents in the view - the sets keep their own counts, so this only has to count bits if there's a mask
+		const int size() const
+		{
+			int count = 0;
+			if((_mask == nullptr) and (_excluded == nullptr))
+			{
+				for(int set = 0; set < _num_sets; ++set){ count += _sets[set]->size(); }
+				return count;
+			}
+			for(int index = 0; index < num_words(); ++index){ count += __builtin_popcountll(word(index)); }
+			return count;
+		}
+		const bool empty() const { return size() == 0; }
+
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, num_words()); }
+};
+
+/*
+	Visits each member of the group with the given chance, independently - the same as drawing one random number per member
+		and keeping those that come up under the chance, but without drawing for everyone. The gap to the next member picked is
+		drawn instead (the number of misses before the next hit is geometrically distributed), and the members in between are
+		skipped a word at a time by counting bits. For chances as small as the background infection rate, that's a handful of
+		draws a day instead of one for every agent.
+
+	Members are visited in order of ID. Like iterating over the group, it reads the words as it goes, so visit() can take the
+		agent it's given (or anyone before them) out of the sets.
+*/
+template<typename Generator, typename Visit> void for_each_sampled(const Agent_Group& group, const double chance, Generator& generator, Visit visit)
+{
+	if(chance <= 0){ return; }
+	if(chance >= 1)
+	{
+		for(const int agent : group){ visit(agent); }
+		return;
+	}
+
+	std::geometric_distribution<long long> gap(chance);
+	long long skip = gap(generator); // the number of members still to be passed over before the next one picked
+	const int num_words = group.num_words();
+	for(int index = 0; index < num_words; ++index)
+	{
+		std::uint64_t bits = group.word(index);
+		int num_left = __builtin_popcountll(bits);
+		while(skip < num_left)
+		{
+			for(int passed = 0; passed < skip; ++passed){ bits &= bits - 1; }
+			num_left -= skip + 1;
+			const int agent = 64*index + __builtin_ctzll(bits);
+			bits &= bits - 1;
+			visit(agent);
+			skip = gap(generator);
+		}
+		skip -= num_left;
+	}
+}
+
+/*
+	Read-only range over a run of agent IDs stored contiguously somewhere else (one row of a Household_Table, for example).
+	It's just a pair of pointers, so it's cheap to hand out and loops over it walk straight through memory.
+*/
+class Agent_Range
+{
+	private:
+
+		const int* _begin;
+		const int* _end;
+
+	public:
+
+		typedef const int* const_iterator;
+		typedef const int* iterator;
+		typedef int value_type;
+
+		Agent_Range() : _begin(nullptr), _end(nullptr) {}
+		Agent_Range(const int* first, const int* last) : _begin(first), _end(last) {}
+		// all of a vector of IDs
+		template<typename Vector> explicit Agent_Range(const Vector& the_IDs) : _begin(the_IDs.data()), _end(the_IDs.data()+the_IDs.size()) {}
+
+		const_iterator begin() const { return _begin; }
+		const_iterator end() const { return _end; }
+		const int size() const { return _end - _begin; }
+		const bool empty() const { return _begin == _end; }
+		const int operator [] (const int index) const { return _begin[index]; }
+};
+
+/*
+	A sorted list of up to Capacity agent IDs, kept right there in the object instead of on the heap, for the groups that have
+		a known limit on their size. It does what Numbered_Groups needs a std::vector to do, and nothing else; trying to put
+		more than Capacity agents in it stops the simulation, since the limit it was built for doesn't hold.
+*/
+template<int Capacity> class Inline_Agent_List
+{
+	private:
+
+		std::array<int, Capacity> _IDs;
+		int _size = 0;
+
+	public:
+
+		typedef int* iterator;
+		typedef const int* const_iterator;
+		typedef int value_type;
+
+		iterator begin() { return _IDs.data(); }
+		iterator end() { return _IDs.data()+_size; }
+		const_iterator begin() const { return _IDs.data(); }
+		const_iterator end() const { return _IDs.data()+_size; }
+		const int* data() const { return _IDs.data(); }
+		const int size() const { return _size; }
+		const bool empty() const { return _size == 0; }
+		void clear() { _size = 0; }
+
+		// put the agent in just before the given spot, same as std::vector::insert
+		iterator insert(iterator spot, const int agent)
+		{
+			if(_size == Capacity)
+			{
+				std::cerr << "\n###### GROUP FULL. More than " << Capacity << " agents in one group; build with -DTOWN_DYNAMIC_CLASSROOMS. ######" << std::endl;
+				std::exit(EXIT_FAILURE);
+			}
+			std::copy_backward(spot, end(), end()+1);
+			*spot = agent;
+			++ _size;
+			return spot;
+		}
+
+		iterator erase(iterator spot)
+		{
+			std::copy(spot+1, end(), spot);
+			-- _size;
+			return spot;
+		}
+};
+
+/*
+	Member lists of a few groups numbered -1, 0, 1, 2, ... (the classrooms, or the cohorts), with each group's members kept in
+		one small sorted vector, and the vectors kept in one dense vector indexed by the group number.
+
+	This stands in for the std::map<int, std::set<int>> we used to use, so it behaves the same way: a group "exists" once something
+		has been put in it (or it's been cleared), even if it's empty, until it's removed; the numbers of the existing groups are
+		kept in order; and the members of a group come out sorted by ID. Groups here are tens of agents at most, so keeping the
+		vectors sorted on insertion is cheaper than chasing the nodes of a std::set around the heap.
+
+	Each group's list is a Member_List: a Town_Vector<int> by default, or an Inline_Agent_List for groups that are known never
+		to get bigger than some fixed size (the classrooms - see Classroom_Groups).
+*/
+template<typename Member_List = Town_Vector<int>> class Numbered_Groups
+{
+	private:
+
+		Town_Vector<Member_List> _members; // index - group number + 1, so that group -1 ("none") fits at the front
+		Town_Vector<char> _exists;
+		Town_Vector<int> _numbers; // numbers of the groups that exist, in order
+
+	public:
+
+		Numbered_Groups() {}
+		explicit Numbered_Groups(Town_Arena* arena) : _members(arena), _exists(arena), _numbers(arena) {}
+
+		const bool exists(const int group) const
+		{
+			return (group+1 >= 0) and (group+1 < (int)_exists.size()) and _exists[group+1];
+		}
+
+		// make sure that the group exists, even if there's nobody in it
+		void create(const int group)
+		{
+			assert(group >= -1);
+			if(group+1 >= (int)_members.size())
+			{
+				_members.resize(group+2);
+				_exists.resize(group+2, false);
+			}
+			if(_exists[group+1]){ return; }
+			_exists[group+1] = true;
+			_numbers.insert(std::lower_bound(_numbers.begin(), _numbers.end(), group), group);
+		}
+
+		// get rid of the group altogether
+		void remove(const int group)
+		{
+			if(not exists(group)){ return; }
+			_members[group+1].clear();
+			_exists[group+1] = false;
+			_numbers.erase(std::lower_bound(_numbers.begin(), _numbers.end(), group));
+		}
+
+		void insert(const int group, const int agent)
+		{
+			create(group);
+			Member_List& the_members = _members[group+1];
+			typename Member_List::iterator spot = std::lower_bound(the_members.begin(), the_members.end(), agent);
+			if((spot == the_members.end()) or (*spot != agent)){ the_members.insert(spot, agent); }
+		}
+
+		void erase(const int group, const int agent)
+		{
+			if(not exists(group)){ return; }
+			Member_List& the_members = _members[group+1];
+			typename Member_List::iterator spot = std::lower_bound(the_members.begin(), the_members.end(), agent);
+			if((spot != the_members.end()) and (*spot == agent)){ the_members.erase(spot); }
+		}
+
+		// empty out the group, but keep it around (and keep the storage)
+		void clear(const int group)
+		{
+			create(group);
+			_members[group+1].clear();
+		}
+
+		// move every member to their new number (new_number_of[old number] = new number)
+		void renumber(const std::vector<int>& new_number_of)
+		{
+			for(Member_List& the_members : _members)
+			{
+				for(int& agent : the_members){ agent = new_number_of[agent]; }
+				std::sort(the_members.begin(), the_members.end());
+			}
+		}
+
+		// empty out everything
+		void clear()
+		{
+			for(Member_List& the_members : _members){ the_members.clear(); }
+			std::fill(_exists.begin(), _exists.end(), false);
+			_numbers.clear();
+		}
+
+		const bool contains(const int group, const int agent) const
+		{
+			if(not exists(group)){ return false; }
+			return std::binary_search(_members[group+1].begin(), _members[group+1].end(), agent);
+		}
+
+		// the members of the group, sorted by ID (no one, if the group doesn't exist)
+		const Agent_Range members(const int group) const
+		{
+			if(not exists(group)){ return Agent_Range(); }
+			return Agent_Range(_members[group+1]);
+		}
+
+		void serialize(std::ostream& out) const { write_binary(out, _members); write_binary(out, _exists); write_binary(out, _numbers); }
+		void deserialize(std::istream& in) { read_binary(in, _members); read_binary(in, _exists); read_binary(in, _numbers); }
+
+		// number of groups that exist
+		const int size() const { return _numbers.size(); }
+		// the numbers of the groups that exist, in order
+		const Agent_Range numbers() const { return Agent_Range(_numbers); }
+};
+
+/*
+	The households, in compressed sparse row layout: the IDs of the members of every household laid end to end in one vector,
+		with the members of household h in _members[_offsets[h-_first_number]] up to _members[_offsets[h-_first_number+1]].
+
+	Nobody moves house once the population has been generated, so the table is built in one go from the household of every
+		agent (see Town::the_households()) and left alone after that. Members come out sorted by ID, like they did from the
+		std::set<int> that each household used to be.
+*/
+class Household_Table
+{
+	private:
+
+		Town_Vector<int> _offsets;
+		Town_Vector<int> _members;
+		Town_Vector<int> _numbers; // numbers of the households with someone living in them, in order
+		int _first_number = 0;
+
+	public:
+
+		Household_Table() {}
+		explicit Household_Table(Town_Arena* arena) : _offsets(arena), _members(arena), _numbers(arena) {}
+
+		// no households at all (the storage is kept)
+		void clear()
+		{
+			_offsets.clear();
+			_members.clear();
+			_numbers.clear();
+			_first_number = 0;
+		}
+
+		// household_of[agent] is the number of the household the agent lives in
+		void build(const Town_Vector<int>& household_of)
+		{
+			_offsets.clear();
+			_members.clear();
+			_numbers.clear();
+			if(household_of.empty()){ return; }
+
+			_first_number = *std::min_element(household_of.begin(), household_of.end());
+			const int last_number = *std::max_element(household_of.begin(), household_of.end());
+
+			// count the members of each house, and add the counts up to get where each house starts
+			_offsets.assign(last_number-_first_number+2, 0);
+			for(const int house : household_of){ ++ _offsets[house-_first_number+1]; }
+			for(int row = 0; row < (int)_offsets.size()-1; ++row)
+			{
+				if(_offsets[row+1] != 0){ _numbers.push_back(row+_first_number); }
+				_offsets[row+1] += _offsets[row];
+			}
+
+			// then drop everyone into place - going through the agents in order leaves every house sorted
+			_members.resize(household_of.size());
+			Town_Vector<int> next_spot(_offsets.begin(), _offsets.end()-1, _offsets.get_allocator());
+			for(int agent = 0; agent < (int)household_of.size(); ++agent){ _members[next_spot[household_of[agent]-_first_number]++] = agent; }
+		}
+
+		const bool contains(const int house) const
+		{
+			const int row = house-_first_number;
+			return (row >= 0) and (row+1 < (int)_offsets.size()) and (_offsets[row+1] > _offsets[row]);
+		}
+
+		// where the house comes in the table: 0 for the lowest-numbered household, and so on up (unused numbers get a row too)
+		const int row(const int house) const { return house-_first_number; }
+		const int num_rows() const { return _offsets.empty() ? 0 : _offsets.size()-1; }
+
+		const int size(const int house) const
+		{
+			assert(contains(house));
+			return _offsets[house-_first_number+1] - _offsets[house-_first_number];
+		}
+
+		const Agent_Range members(const int house) const
+		{
+			assert(contains(house));
+			return Agent_Range(_members.data()+_offsets[house-_first_number], _members.data()+_offsets[house-_first_number+1]);
+		}
+
+		void serialize(std::ostream& out) const
+		{
+			write_binary(out, _offsets);
+			write_binary(out, _members);
+			write_binary(out, _numbers);
+			write_binary(out, _first_number);
+		}
+		void deserialize(std::istream& in)
+		{
+			read_binary(in, _offsets);
+			read_binary(in, _members);
+			read_binary(in, _numbers);
+			read_binary(in, _first_number);
+		}
+
+		// number of households with anyone in them
+		const int num_households() const { return _numbers.size(); }
+		// the numbers of the households with anyone in them, in order
+		const Agent_Range numbers() const { return Agent_Range(_numbers); }
+};
+
+/*
+	Read-only view of all the groups in a Numbered_Groups except group -1 (the "not in a group" group): iterating over it gives
+		(group number, members) pairs in order of the group number, the same as iterating over a std::map<int, std::set<int>>,
+		without copying anything.
+*/
+template<typename Groups> class Group_List_View
+{
+	private:
+
+		const Groups* _groups;
+
+	public:
+
+		typedef std::pair<int, Agent_Range> value_type;
+
+		class const_iterator
+		{
+			private:
+
+				const Groups* _groups;
+				Agent_Range::const_iterator _number;
+
+			public:
+
+				typedef std::forward_iterator_tag iterator_category;
+				typedef typename Group_List_View::value_type value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const value_type* pointer;
+				typedef value_type reference;
+
+				const_iterator(const Groups* groups, Agent_Range::const_iterator number) : _groups(groups), _number(number) {}
+
+				value_type operator * () const { return value_type(*_number, _groups->members(*_number)); }
+				const_iterator& operator ++ () { ++_number; return *this; }
+				const_iterator operator ++ (int) { const_iterator old = *this; ++(*this); return old; }
+				bool operator == (const const_iterator& other) const { return _number == other._number; }
+				bool operator != (const const_iterator& other) const { return _number != other._number; }
+		};
+		typedef const_iterator iterator;
+
+		Group_List_View(const Groups* groups) : _groups(groups) {}
+
+		const_iterator begin() const { return const_iterator(_groups, _groups->numbers().begin() + _groups->exists(-1)); }
+		const_iterator end() const { return const_iterator(_groups, _groups->numbers().end()); }
+		const int size() const { return _groups->size() - _groups->exists(-1); }
+		const bool empty() const { return size() == 0; }
+};
+
+/*
+	Read-only view of all the households in a Household_Table: iterating over it gives (house number, members) pairs in order
+		of the house number, with the members as an Agent_Range into the table.
+*/
+class Household_List_View
+{
+	private:
+
+		const Household_Table* _houses;
+
+	public:
+
+		typedef std::pair<int, Agent_Range> value_type;
+
+		class const_iterator
+		{
+			private:
+
+				const Household_Table* _houses;
+				Agent_Range::const_iterator _number;
+
+			public:
+
+				typedef std::forward_iterator_tag iterator_category;
+				typedef Household_List_View::value_type value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const value_type* pointer;
+				typedef value_type reference;
+
+				const_iterator(const Household_Table* houses, Agent_Range::const_iterator number) : _houses(houses), _number(number) {}
+
+				value_type operator * () const { return value_type(*_number, _houses->members(*_number)); }
+				const_iterator& operator ++ () { ++_number; return *this; }
+				const_iterator operator ++ (int) { const_iterator old = *this; ++(*this); return old; }
+				bool operator == (const const_iterator& other) const { return _number == other._number; }
+				bool operator != (const const_iterator& other) const { return _number != other._number; }
+		};
+		typedef const_iterator iterator;
+
+		Household_List_View(const Household_Table* houses) : _houses(houses) {}
+
+		const_iterator begin() const { return const_iterator(_houses, _houses->numbers().begin()); }
+		const_iterator end() const { return const_iterator(_houses, _houses->numbers().end()); }
+		const int size() const { return _houses->num_households(); }
+		const bool empty() const { return size() == 0; }
+};
+
+// sets of agents print the same way a std::set<int> does
+namespace pretty_print
+{
+	template<> struct delimiters<Agent_Bitset, char> { static const delimiters_values<char> values; };
+	const delimiters_values<char> delimiters<Agent_Bitset, char>::values = { "{", ", ", "}" };
+	template<> struct delimiters<Agent_Group, char> { static const delimiters_values<char> values; };
+	const delimiters_values<char> delimiters<Agent_Group, char>::values = { "{", ", ", "}" };
+	template<> struct delimiters<Agent_Range, char> { static const delimiters_values<char> values; };
+	const delimiters_values<char> delimiters<Agent_Range, char>::values = { "{", ", ", "}" };
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef REAL_TRANSMISSION_KERNEL_HPP_
+#define REAL_TRANSMISSION_KERNEL_HPP_
+
+#include <cmath>
+#if (defined(__x86_64__) or defined(__i386__)) and (defined(__GNUC__) or defined(__clang__)) and not defined(REAL_SCALAR_TRANSMISSION)
+	#define REAL_X86_TRANSMISSION
+	#include <immintrin.h>
+#endif
+
+/*
+	Deciding a whole row of infectious-susceptible pairs at once, for the pair-by-pair transmission in the classrooms and the
+		common area: one infectious agent against every susceptible in the room.
+
+	The simulation still draws one random number per pair, in the same order as ever (so the runs are the same, draw for
+		draw), but it draws the whole row into a buffer first, and then the comparisons of the draws against the chances of
+		infection are done a vector register at a time: eight pairs per instruction with AVX2, four with SSE. Which one gets
+		used is worked out once, when the program starts, from what the CPU can do; build with -DREAL_SCALAR_TRANSMISSION to
+		use plain loops everywhere.
+
+	The chances are worked out in double precision, and the draws are floats. To compare them in single precision without
+		changing any outcome, each chance is turned into a threshold: the smallest float at or above it. A float draw is below
+		the chance exactly when it's below the threshold, since there's no float in between.
+*/
+
+// the smallest float at or above the chance
+inline float draw_threshold(const double chance)
+{
+	float threshold = (float)chance;
+	if((double)threshold < chance){ threshold = std::nextafter(threshold, INFINITY); }
+	return threshold;
+}
+
+// the same for draws that count if they're at or below the chance: the smallest float above it
+inline float draw_threshold_at_or_below(const double chance)
+{
+	float threshold = draw_threshold(chance);
+	if((double)threshold == chance){ threshold = std::nextafter(threshold, INFINITY); }
+	return threshold;
+}
+
+/*
+	the bernoulli_hits functions: puts the index of every pair with draws[pair] < thresholds[pair] (pair = 0 to num_pairs-1) in
+		hits, in order, and gives back how many there were. hits needs room for num_pairs indices
+*/
+inline int bernoulli_hits_scalar(const float* draws, const float* thresholds, const int num_pairs, int* hits)
+{
+	int num_hits = 0;
+	for(int pair = 0; pair < num_pairs; ++pair)
+	{
+		hits[num_hits] = pair;
+		num_hits += (draws[pair] < thresholds[pair]);
+	}
+	return num_hits;
+}
+
+#ifdef REAL_X86_TRANSMISSION
+
+	// every x86-64 CPU has SSE2, but it's marked here too for 32-bit builds
+	__attribute__((target("sse2"))) inline int bernoulli_hits_sse(const float* draws, const float* thresholds, const int num_pairs, int* hits)
+	{
+		int num_hits = 0;
+		int pair = 0;
+		for(; pair+4 <= num_pairs; pair += 4)
+		{
+			int mask = _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(draws+pair), _mm_loadu_ps(thresholds+pair)));
+			while(mask != 0)
+			{
+				hits[num_hits++] = pair + __builtin_ctz(mask);
+				mask &= mask - 1;
+			}
+		}
+		// the last few that don't fill a register
+		for(; pair < num_pairs; ++pair)
+		{
+			hits[num_hits] = pair;
+			num_hits += (draws[pair] < thresholds[pair]);
+		}
+		return num_hits;
+	}
+
+	__attribute__((target("avx2"))) inline int bernoulli_hits_avx2(const float* draws, const float* thresholds, const int num_pairs, int* hits)
+	{
+		int num_hits = 0;
+		int pair = 0;
+		for(; pair+8 <= num_pairs; pair += 8)
+		{
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(draws+pair), _mm256_loadu_ps(thresholds+pair), _CMP_LT_OQ));
+			while(mask != 0)
+			{
+				hits[num_hits++] = pair + __builtin_ctz(mask);
+				mask &= mask - 1;
+			}
+		}
+		for(; pair < num_pairs; ++pair)
+		{
+			hits[num_hits] = pair;
+			num_hits += (draws[pair] < thresholds[pair]);
+		}
+		return num_hits;
+	}
+
+#endif
+
+typedef int (*Bernoulli_Kernel)(const float*, const float*, const int, int*);
+
+// the best of the above for the CPU we're running on
+inline Bernoulli_Kernel pick_bernoulli_kernel()
+{
+#ifdef REAL_X86_TRANSMISSION
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")){ return bernoulli_hits_avx2; }
+	if(__builtin_cpu_supports("sse2")){ return bernoulli_hits_sse; }
+#endif
+	return bernoulli_hits_scalar;
+}
+
+const Bernoulli_Kernel bernoulli_hits = pick_bernoulli_kernel();
+
+#endif
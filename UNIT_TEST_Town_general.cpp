@@ -73,5 +73,53 @@ int main()
 
 	std::cout << "\n################################################################################" << std::endl;
 
+	// forking the town, and writing it out and reading it back in. the fork should be independent of the original, and the town
+	// read back in should write out the same snapshot again
+	std::cout << "\nTEST: forking the town. the fork should print the same as the original\n";
+	Town Fork = Barbados;
+	Fork.print_compartments();
+	Fork.print_classrooms();
+	std::cout << "TEST: changing agent 2 from S to R in the fork only. the original should still have them in S\n";
+	Fork.set_status(2, 'R');
+	Barbados.print_compartments();
+	if((Fork.Agent(2).status() != 'R') or (Barbados.Agent(2).status() != 'S'))
+	{
+		std::cerr << "\n###### THE FORK ISN'T INDEPENDENT OF THE ORIGINAL. ######" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "\nTEST: writing the town out and reading it back in. the snapshot should print the same as the original\n";
+	std::stringstream snapshot(std::ios::in | std::ios::out | std::ios::binary);
+	Barbados.serialize(snapshot);
+	Town Restored;
+	Restored.deserialize(snapshot);
+	Restored.print_compartments();
+	Restored.print_classrooms();
+	std::cout << "TEST: agent 5 thinks she's in class " << Restored.Agent(5).classroom() << std::endl;
+
+	// written out again, the town that was read back in should give exactly the same snapshot
+	std::stringstream second_snapshot(std::ios::in | std::ios::out | std::ios::binary);
+	Restored.serialize(second_snapshot);
+	if(second_snapshot.str() != snapshot.str())
+	{
+		std::cerr << "\n###### THE TOWN READ BACK IN ISN'T THE ONE WRITTEN OUT. ######" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "TEST: the snapshot of the town read back in matches the first one, byte for byte\n";
+
+	// a container size bigger than the rest of the snapshot should fail the read, without making room for it
+	std::stringstream corrupt(std::ios::in | std::ios::out | std::ios::binary);
+	write_binary(corrupt, (std::int64_t)1 << 40);
+	std::vector<int> never_filled;
+	read_binary(corrupt, never_filled);
+	if(corrupt or (not never_filled.empty()))
+	{
+		std::cerr << "\n###### A CORRUPT SNAPSHOT SIZE WAS READ AS IS. ######" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "TEST: a corrupt size in a snapshot fails the read\n";
+
+	std::cout << "\n################################################################################" << std::endl;
+
 	return 0;
 }
@@ -0,0 +1,75 @@
+#include "REAL_Town.hpp"
+#include <cmath>
+
+int main()
+{
+	// a group of agents: every third one of 30000 is susceptible, and every fifth one of those is left out of the group
+	const int Num_Agents = 30000;
+	Agent_Bitset susceptibles, left_out;
+	susceptibles.resize(Num_Agents);
+	left_out.resize(Num_Agents);
+	for(int agent = 0; agent < Num_Agents; agent += 3)
+	{
+		susceptibles.insert(agent);
+		if(agent%5 == 0){ left_out.insert(agent); }
+	}
+	Agent_Group the_group;
+	the_group.add(&susceptibles);
+	the_group.exclude(&left_out);
+	const int Group_Size = the_group.size();
+	std::cout << "TEST: " << Group_Size << " agents in the group (every third agent, but not every fifth one of those)\n";
+
+	std::mt19937 generator(2021);
+	const int Num_Rounds = 200;
+
+	// the number visited should be about chance*Group_Size each round, and nobody should be visited who isn't in the group
+	for(const double chance : {0.0005, 0.01, 0.2})
+	{
+		long long num_visited = 0;
+		for(int round = 0; round < Num_Rounds; ++round)
+		{
+			int last_visited = -1;
+			bool in_order = true, in_the_group = true;
+			for_each_sampled(the_group, chance, generator, [&](const int agent)
+			{
+				in_order = in_order and (agent > last_visited);
+				in_the_group = in_the_group and susceptibles.contains(agent) and (not left_out.contains(agent));
+				last_visited = agent;
+				++num_visited;
+			});
+			if((not in_order) or (not in_the_group))
+			{
+				std::cerr << "\n###### VISITED AN AGENT OUT OF ORDER, OR ONE NOT IN THE GROUP. ######" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+
+		// the hits over all the rounds are binomial, so they should come out within a few standard deviations of the mean
+		const double expected = chance*Group_Size*Num_Rounds;
+		const double z_score = (num_visited - expected)/std::sqrt(expected*(1 - chance));
+		std::cout << "TEST: chance " << chance << ": visited " << num_visited/(1.*Num_Rounds*Group_Size) << " of the group per round, z-score " << z_score << "\n";
+		if(std::abs(z_score) > 5)
+		{
+			std::cerr << "\n###### THE HIT RATE IS OFF FROM THE CHANCE GIVEN. ######" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// with no chance nobody is visited, and with a sure chance everybody is
+	int num_visited = 0;
+	for_each_sampled(the_group, 0, generator, [&](const int){ ++num_visited; });
+	if(num_visited != 0)
+	{
+		std::cerr << "\n###### VISITED SOMEONE WITH NO CHANCE. ######" << std::endl;
+		return EXIT_FAILURE;
+	}
+	for_each_sampled(the_group, 1, generator, [&](const int){ ++num_visited; });
+	if(num_visited != Group_Size)
+	{
+		std::cerr << "\n###### DIDN'T VISIT EVERYONE WITH A SURE CHANCE. ######" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "TEST: nobody visited with chance 0, and everybody with chance 1\n";
+
+	return 0;
+}